@@ -119,6 +119,10 @@ Diagram* VoronoiDiagramGenerator::relax() {
 	//	  to get the whole cell's centroid
 	for (Cell* c : diagram->cells) {
 		size_t edgeCount = c->halfEdges.size();
+		if (edgeCount < 3) {
+			sites.push_back(c->site.p);
+			continue;
+		}
 		verts.resize(edgeCount);
 		vectors.resize(edgeCount);
 
@@ -0,0 +1,43 @@
+#ifndef BATCH_SIMULATOR_H_
+#define BATCH_SIMULATOR_H_
+
+#include "mapgen/Economy.hpp"
+#include "mapgen/Market.hpp"
+#include "mapgen/Report.hpp"
+#include "mapgen/TradeMatrix.hpp"
+
+struct Distribution {
+  std::vector<float> values;
+  float min = 0.f;
+  float max = 0.f;
+  float mean = 0.f;
+  float deviation = 0.f;
+
+  void update();
+  std::vector<float> histogram(int bins);
+};
+
+// Runs many independent economy simulations over the same cities and
+// roads in parallel. Every run gets its own EconomyVars and RNG stream.
+class BatchSimulator {
+public:
+  BatchSimulator(Market *m, TradeMatrix *t, int s);
+  void run(std::vector<EconomyVars> runs, int years);
+
+  static std::vector<EconomyVars> sweep(EconomyVars base,
+                                        float EconomyVars::*field, float from,
+                                        float to, int count);
+
+  std::vector<EconomyVars> vars;
+  std::vector<Report> reports;
+  Distribution population;
+  Distribution wealth;
+  int threads = 0;
+
+private:
+  Market *market;
+  TradeMatrix *trade;
+  int seed;
+};
+
+#endif
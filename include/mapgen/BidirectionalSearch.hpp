@@ -0,0 +1,40 @@
+#ifndef BIDIRECTIONAL_SEARCH_H_
+#define BIDIRECTIONAL_SEARCH_H_
+
+#include "Map.hpp"
+#include "micropather.h"
+
+// Bidirectional A* over the region graph, meant to be kept for many
+// queries. Both searches use the average of the forward and backward
+// heuristics as potential, so the first meeting bound is exact. Node state
+// lives in flat arrays indexed by region id and is reset lazily through a
+// generation stamp; the open lists keep their storage between queries.
+class BidirectionalSearch {
+public:
+  BidirectionalSearch(Map *m);
+  bool getPath(Region *from, Region *to, micropather::MPVector<void *> *path,
+               float *cost);
+
+  // Regions settled so far, both directions and all queries together.
+  long expanded = 0;
+
+private:
+  typedef std::pair<float, int> Item;
+  void touch(int v);
+  void push(int side, float key, int v);
+  Item pop(int side);
+
+  Map *map;
+  Region *target = nullptr;
+  Region *source = nullptr;
+  int generation = 0;
+  std::vector<int> stamp;
+  std::vector<float> potential;
+  std::vector<float> g[2];
+  std::vector<int> prev[2];
+  std::vector<bool> closed[2];
+  std::vector<Item> open[2];
+  MP_VECTOR<micropather::StateCost> adjacent;
+};
+
+#endif
@@ -13,6 +13,12 @@ namespace biom {
 const float DEFAULT_HUMIDITY = 0.f;
   const float DEFAULT_TEMPERATURE = 30.f;
 
+  const float LATITUDE_TEMPERATURE = 0.5f;
+  const float EVAPORATION = 0.15f;
+  const float PRECIPITATION = 0.04f;
+  const float OROGRAPHIC_PRECIPITATION = 4.f;
+  const float INLAND_MOISTURE = 0.3f;
+
   const Biom ABYSS = {-2.0000, sf::Color(23, 23, 40), "Abyss", 0};
   const Biom DEEP = {-1.0000, sf::Color(39, 39, 70), "Deep", 0};
   const Biom SHALLOW = {-0.2500, sf::Color(51, 51, 91), "Shallow", 0};
@@ -7,20 +7,21 @@
 #include "mapgen/Economy.hpp"
 
 class Package;
+class TradeMatrix;
 class City : public Location {
 public:
   City(Region* r, std::string n, LocationType t);
-  Package* makeGoods(int y);
-  int buyGoods(std::vector<Package*>* goods);
-  EconomyVars* economyVars;
+
+  int id = 0;
+  TradeMatrix* trade = nullptr;
 
   bool isCapital = false;
 
-  int population = 1000;
-  float wealth = 1;
+  int population = Economy::INITIAL_POPULATION;
+  float wealth = Economy::INITIAL_WEALTH;
   std::vector<Road*> roads;
-  std::map<City*,float> cache;
   float getPrice(Package* p);
+  float getPrice(City* seller);
 private:
   friend std::ostream& operator<<(std::ostream &strm, const City &c);
 };
@@ -0,0 +1,59 @@
+#ifndef CLUSTER_PATHER_H_
+#define CLUSTER_PATHER_H_
+
+#include "Map.hpp"
+#include "micropather.h"
+
+// HPA*-style pathfinder over the map's clusters. A few portal edges are
+// kept on each cluster border, and portals inside a cluster are linked by
+// their in-cluster costs. A query searches this abstract graph and then
+// refines only the chosen corridor, one cluster at a time. Paths are
+// near-optimal rather than optimal. Build again when edge costs change.
+class ClusterPather {
+public:
+  typedef std::vector<std::vector<std::pair<int, float>>> Graph;
+
+  // Search scratch for one thread.
+  class Query {
+  public:
+    Query(ClusterPather *p);
+    bool getPath(Region *from, Region *to, micropather::MPVector<void *> *path,
+                 float *cost);
+    // Dijkstra that never leaves the cluster of s; stops once every region
+    // in targets is settled.
+    void local(int s, Graph &graph, const std::vector<int> &targets);
+
+    std::vector<float> dist;
+    std::vector<int> prev;
+    std::vector<int> stamp;
+    std::vector<int> wanted;
+    int generation = 0;
+    // Regions and portals settled so far, over all queries.
+    long expanded = 0;
+
+  private:
+    void touch(int v);
+    bool refine(int a, int b, std::vector<int> &nodes);
+
+    ClusterPather *cp;
+    std::vector<float> adist;
+    std::vector<int> aprev;
+    std::vector<int> astamp;
+    int ageneration = 0;
+  };
+
+  ClusterPather(Map *m);
+
+private:
+  Map *map;
+  int size;
+  Graph out;
+  Graph in;
+  std::vector<int> clusterOf;
+  std::vector<int> portalOf;
+  std::vector<int> portals;
+  std::vector<std::vector<int>> clusterPortals;
+  Graph abstract;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef CONTRACTION_HIERARCHY_H_
+#define CONTRACTION_HIERARCHY_H_
+
+#include "Map.hpp"
+#include "micropather.h"
+
+// Contraction hierarchy over Map's region graph, built from the current
+// edge costs. Regions are contracted by edge difference; each query then
+// only searches upward from both ends. Build again when costs change.
+class ContractionHierarchy {
+public:
+  struct Edge {
+    int node;
+    float cost;
+    int middle;
+  };
+
+  // Search scratch for one thread. Queries on a shared hierarchy need one
+  // Query each.
+  class Query {
+  public:
+    Query(ContractionHierarchy *h);
+    float getCost(Region *from, Region *to);
+    bool getPath(Region *from, Region *to, micropather::MPVector<void *> *path,
+                 float *cost);
+    // Row-major costs, from.size() x to.size().
+    std::vector<float> getTable(const std::vector<Region *> &from,
+                                const std::vector<Region *> &to);
+
+    // Regions settled so far by point-to-point searches.
+    long expanded = 0;
+
+  private:
+    int search(int s, int t);
+    void upward(int s, std::vector<std::vector<Edge>> &graph,
+                std::vector<int> &settled);
+    void touch(int v);
+
+    ContractionHierarchy *ch;
+    int generation = 0;
+    std::vector<int> stamp;
+    std::vector<float> dist[2];
+    std::vector<int> parent[2];
+    std::vector<std::vector<std::pair<int, float>>> buckets;
+  };
+
+  ContractionHierarchy(Map *m);
+  int shortcuts = 0;
+
+private:
+  void addEdge(int u, int x, float c, int m);
+  int countShortcuts(int v, bool contract);
+  void witness(int u, int v, float limit);
+  Edge *findEdge(int a, int b);
+  void unpack(int a, int b, std::vector<int> &nodes);
+
+  Map *map;
+  int size;
+  std::vector<int> rank;
+  std::vector<std::vector<Edge>> out;
+  std::vector<std::vector<Edge>> in;
+  std::vector<std::vector<Edge>> up;
+  std::vector<std::vector<Edge>> down;
+
+  std::vector<bool> contracted;
+  std::vector<float> witnessCost;
+  std::vector<int> witnessStamp;
+  int witnessGeneration = 0;
+};
+
+#endif
@@ -2,6 +2,9 @@
 #define ECONOMY_H_
 
 namespace Economy {
+  const int INITIAL_POPULATION = 1000;
+  const float INITIAL_WEALTH = 1;
+
   const float POPULATION_GROWS = 0.04;
   const float POPULATION_GROWS_WEALTH_MODIFIER = 0.1;
 
@@ -0,0 +1,23 @@
+#ifndef ECONOMY_KERNELS_H_
+#define ECONOMY_KERNELS_H_
+
+// Per-year kernels over EconomyRun's population and wealth columns. Loops
+// are blocked into fixed lanes so they vectorize without -ffast-math.
+namespace kernels {
+const int LANES = 8;
+
+// Column sum, min and max. min ignores values equal to skip (untouched
+// cities), matching how Report tracks them.
+template <typename T> struct Reduction {
+  T sum;
+  T min;
+  T max;
+};
+
+void growPopulation(int *population, const float *wealth, int n, float grows,
+                    float modifier);
+
+template <typename T> Reduction<T> reduce(const T *values, int n, T skip);
+} // namespace kernels
+
+#endif
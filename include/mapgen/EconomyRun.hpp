@@ -0,0 +1,58 @@
+#ifndef ECONOMY_RUN_H_
+#define ECONOMY_RUN_H_
+
+#include "mapgen/Economy.hpp"
+#include "mapgen/Market.hpp"
+#include "mapgen/Package.hpp"
+#include "mapgen/Pool.hpp"
+#include "mapgen/Report.hpp"
+#include "mapgen/TradeMatrix.hpp"
+#include <random>
+
+// Compact copy of a run's state: year, population, wealth and the report
+// series packed into one buffer. Economy vars are not stored, so a restored
+// run can branch with different parameters.
+class EconomySnapshot {
+public:
+  int year = 0;
+  std::vector<char> data;
+};
+
+// One economy simulation over a fixed set of cities and roads. Population
+// and wealth live here, indexed by city id, so several runs can share the
+// same Market and TradeMatrix.
+class EconomyRun {
+public:
+  EconomyRun(Market *m, TradeMatrix *t, EconomyVars v, unsigned int seed);
+  void reset();
+  void step();
+  void run(int years);
+  EconomySnapshot snapshot();
+  bool restore(const EconomySnapshot &s);
+
+  EconomyVars vars;
+  int year = 0;
+  std::vector<int> population;
+  std::vector<float> wealth;
+  Report report;
+  bool verbose = false;
+
+private:
+  void economyTick();
+  void populationTick();
+  Package *makeGoods(City *c);
+  unsigned int buyGoods(City *c);
+  unsigned int buy(City *buyer, PackageType type, unsigned int needed);
+  void sell(Package *p, City *buyer, float price, unsigned int c);
+
+  Market *market;
+  TradeMatrix *trade;
+  unsigned int seed;
+  std::mt19937 gen;
+  std::vector<City *> order;
+  Pool<Package> packages;
+  std::vector<Package *> goods;
+  std::vector<Package *> book[2];
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef INCREMENTAL_PATH_H_
+#define INCREMENTAL_PATH_H_
+
+#include "Map.hpp"
+#include "micropather.h"
+#include <set>
+
+// D* Lite rooted at a fixed source region. It keeps costs from the source
+// for as much of the graph as the targets asked so far needed, and repairs
+// them when edge costs change instead of searching again. Targets may
+// change between queries. Roads only make edges cheaper, so the heuristic
+// is scaled down by ROAD_COST up front to stay admissible.
+// Edges are read from the map's packed arrays, so the map must not be
+// repacked while a search is in use. reset() moves the root; scratch is
+// cleared lazily through a generation stamp.
+class IncrementalPath {
+public:
+  IncrementalPath(Map *m);
+  void reset(Region *s);
+  bool getPath(Region *target, micropather::MPVector<void *> *path,
+               float *cost);
+  // Costs of edges into r changed.
+  void updateRegion(Region *r);
+
+  long expanded = 0;
+
+private:
+  typedef std::pair<float, float> Key;
+  struct InEdge {
+    int from;
+    const micropather::StateCost *edge;
+  };
+  void touch(int s);
+  Key calculateKey(int s);
+  float heuristic(int a, int b);
+  void updateVertex(int u);
+  void computePath();
+
+  Map *map;
+  int source = -1;
+  int target = -1;
+  float km = 0.f;
+  float scale;
+  int generation = 0;
+  int walk = 0;
+  std::vector<int> stamp;
+  std::vector<int> onPath;
+  std::vector<float> g;
+  std::vector<float> rhs;
+  std::vector<Key> keys;
+  std::vector<bool> queued;
+  std::set<std::pair<Key, int>> queue;
+  std::vector<int> inOffsets;
+  std::vector<InEdge> inEdges;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef ISOCHRONE_H_
+#define ISOCHRONE_H_
+
+#include "Map.hpp"
+#include "micropather.h"
+#include <functional>
+
+// Cost-bounded expansion over the region graph, like
+// MicroPather::SolveForNearStates but from a whole set of sources at once.
+// Each reached region keeps its travel cost and the source it was reached
+// from, so one expansion gives every source's catchment area. The search
+// can be kept to one megaCluster and can stop once enough goal regions are
+// settled. Scratch is reset through a generation stamp and can be reused.
+class Isochrone {
+public:
+  Isochrone(Map *m);
+  void expand(const std::vector<Region *> &sources, float maxCost,
+              MegaCluster *within = nullptr, int goals = 0,
+              const std::function<bool(Region *)> &isGoal = nullptr);
+  bool reached(Region *r);
+  float getCost(Region *r);
+  // Index into the sources of the last expansion.
+  int getSource(Region *r);
+
+  // Regions reached by the last expansion, cheapest first.
+  std::vector<Region *> regions;
+  // Goal regions settled by the last expansion, cheapest first.
+  std::vector<Region *> found;
+
+  // One expansion per source on a pool of worker threads, each kept to its
+  // source's megaCluster and stopped after `goals` goal regions. Entry i
+  // holds the goals found from sources[i], cheapest first.
+  static std::vector<std::vector<Region *>>
+  nearestEach(Map *map, const std::vector<Region *> &sources, int goals,
+              const std::function<bool(Region *)> &isGoal);
+
+private:
+  void touch(int id);
+
+  Map *map;
+  int generation = 0;
+  std::vector<int> stamp;
+  std::vector<bool> closed;
+  std::vector<float> cost;
+  std::vector<int> source;
+  MP_VECTOR<micropather::StateCost> adjacent;
+};
+
+#endif
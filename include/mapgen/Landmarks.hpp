@@ -0,0 +1,29 @@
+#ifndef LANDMARKS_H_
+#define LANDMARKS_H_
+
+#include "Region.hpp"
+#include <utility>
+
+class Map;
+// ALT preprocessing: exact costs from and to a few far-apart landmark
+// regions. Through the triangle inequality they bound the cost between any
+// two regions from below. Valid only while edge costs stay unchanged.
+class Landmarks {
+public:
+  Landmarks(Map *m, int count);
+  float estimate(Region *from, Region *to);
+
+  std::vector<Region *> regions;
+
+private:
+  typedef std::vector<std::vector<std::pair<int, float>>> Graph;
+  void dijkstra(int s, Graph &graph, std::vector<float> &dist);
+
+  int size;
+  int count = 0;
+  // Region-major: [region * count + landmark].
+  std::vector<float> from;
+  std::vector<float> to;
+};
+
+#endif
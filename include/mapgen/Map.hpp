@@ -7,6 +7,11 @@
 #include "micropather.h"
 #include <cstring>
 
+// Cost multiplier for entering a region that already has a road.
+const float ROAD_COST = 0.2f;
+
+class Landmarks;
+class SeaLanes;
 class Map : public micropather::Graph {
 public:
   ~Map();
@@ -23,11 +28,33 @@ public:
   std::vector<Road *> roads;
 
   std::string status = "";
+  int landmarkCount = 16;
+  bool useSeaLanes = true;
 
   float getRegionDistance(Region *r, Region *r2);
   float LeastCostEstimate(void *stateStart, void *stateEnd);
   void AdjacentCost(void *state, MP_VECTOR<micropather::StateCost> *adjacent);
+  void IncomingCost(void *state, MP_VECTOR<micropather::StateCost> *incoming);
+  // Packed out-edges of r, empty before updateEdges. Costs are updated in
+  // place by updateEdges(road); a full update repacks them.
+  const micropather::StateCost *edgesBegin(Region *r);
+  const micropather::StateCost *edgesEnd(Region *r);
   void PrintStateInfo(void *state);
+  void updateEdges(bool withLandmarks = false);
+  void updateEdges(Road *road);
+  float getMinCostRatio();
+  void expandSeaLanes(micropather::MPVector<void *> *path);
+
+private:
+  bool isPassable(Region *r, Region *n);
+  float getEdgeCost(Region *r, Region *n);
+  void packSeaLanes();
+
+  std::vector<int> edgeOffsets;
+  std::vector<micropather::StateCost> edges;
+  float minCostRatio = 0.f;
+  Landmarks *landmarks = nullptr;
+  SeaLanes *seaLanes = nullptr;
 
 };
 
@@ -35,6 +35,8 @@ public:
   void setFrequency(float freq);
   void setPointCount(int count);
   int getPointCount();
+  void setStatesCount(int count);
+  int getStatesCount();
   int getOctaveCount();
   int getRelax();
   float getFrequency();
@@ -45,8 +47,12 @@ public:
   std::vector<Region *> getRegions();
   void setMapTemplate(const char *t);
   void startSimulation();
+  void startBatch(std::vector<EconomyVars> runs);
+  void continueSimulation(int years);
+  void restoreSnapshot(int i);
 
   bool simpleRivers;
+  bool climate;
   bool ready;
   float temperature;
   Map *map;
@@ -64,20 +70,25 @@ private:
   void makeRivers();
   void makeClusters();
   void makeMegaClusters();
+  void makeCoasts();
   void makeRelax();
   void makeRiver(Region *r);
   void calcHumidity();
+  void makeClimate();
+  float getLatitude(Region *r);
   void calcTemp();
   void simplifyRivers();
   void makeBorders();
   void makeMinerals();
   void makeCities();
   void makeStates();
+  void makeStateSeeds();
+  void floodStates();
 
-  void getSea(std::vector<Region *> *seas, Region *base, Region *r);
   int _seed;
   VoronoiDiagramGenerator _vdg;
   int _pointsCount;
+  int _statesCount;
   int _w;
   int _h;
   int _relax;
@@ -0,0 +1,18 @@
+#ifndef MARKET_H_
+#define MARKET_H_
+
+#include "City.hpp"
+#include "Package.hpp"
+
+class Market {
+public:
+  Market(std::vector<City *> c);
+  const std::vector<City *> &getSuppliers(City *buyer, PackageType type);
+
+  std::vector<City *> cities;
+
+private:
+  std::vector<std::vector<City *>> suppliers[2];
+};
+
+#endif
@@ -12,10 +12,8 @@ class Package {
 public:
   Package (City* owner, PackageType type, unsigned int count);
   City* owner;
-  std::vector<City*> ports;
   PackageType type;
   unsigned int count = 0;
-  void buy(City* buyer, float price, unsigned int c);
 };
 
 #endif
@@ -0,0 +1,48 @@
+#ifndef PATH_CACHE_H_
+#define PATH_CACHE_H_
+
+#include "Map.hpp"
+#include "micropather.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+// Path cache shared by all pathfinding workers of one stage. Every solved
+// path stores, for each region on it, the next step toward its end and
+// that step's cost, so any later query that starts on a cached path and
+// ends at the same region is a hit. A hit may follow links stored by
+// different paths, so its cost is summed over the steps it takes. Entries
+// are sharded by (start, end) with one mutex per shard. Valid only while
+// edge costs stay unchanged. An entry is never overwritten, so callers
+// that want results independent of thread timing add paths in a fixed
+// order between rounds of lookups.
+class PathCache {
+public:
+  PathCache(Map *m, int shards = 64);
+  bool find(Region *start, Region *end, micropather::MPVector<void *> *path,
+            float *cost);
+  void add(const std::vector<void *> &path);
+  void getCacheData(micropather::CacheData *data);
+
+private:
+  struct Entry {
+    int next;
+    float step;
+  };
+  struct Shard {
+    std::mutex lock;
+    std::unordered_map<unsigned long long, Entry> entries;
+  };
+
+  unsigned long long key(int start, int end);
+  Shard &shard(unsigned long long k);
+  bool lookup(int start, int end, Entry &e);
+
+  Map *map;
+  std::vector<Shard> shards;
+  std::atomic<int> hits;
+  std::atomic<int> misses;
+  std::atomic<int> count;
+};
+
+#endif
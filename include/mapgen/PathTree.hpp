@@ -0,0 +1,35 @@
+#ifndef PATH_TREE_H_
+#define PATH_TREE_H_
+
+#include "Map.hpp"
+#include "micropather.h"
+
+// Single-source Dijkstra over the region graph with Map's edge costs.
+// Scratch arrays are indexed by region id and invalidated by bumping a
+// generation counter, so one tree can be reused for many sources.
+class PathTree {
+public:
+  PathTree(Map *m);
+  void expand(Region *source, const std::vector<Region *> &targets);
+  bool reached(Region *r);
+  float getCost(Region *r);
+  void getPath(Region *target, micropather::MPVector<void *> *path);
+
+  // Regions settled so far, over all expansions.
+  long expanded = 0;
+
+private:
+  void touch(int id);
+
+  Map *map;
+  Region *source = nullptr;
+  int generation = 0;
+  std::vector<int> stamp;
+  std::vector<int> goal;
+  std::vector<bool> closed;
+  std::vector<float> cost;
+  std::vector<Region *> prev;
+  MP_VECTOR<micropather::StateCost> adjacent;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <deque>
+#include <new>
+#include <utility>
+
+// Object pool with arena semantics: objects are handed out in order and
+// all of them are recycled at once by reset(). Storage only grows to the
+// high-water mark and pointers stay valid until the next reset(). Recycled
+// slots are destroyed and rebuilt in place, so constructors may register
+// `this` elsewhere.
+template <typename T> class Pool {
+public:
+  template <typename... Args> T *make(Args &&... args) {
+    if (used < items.size()) {
+      T *item = &items[used];
+      item->~T();
+      new (item) T(std::forward<Args>(args)...);
+    } else {
+      items.emplace_back(std::forward<Args>(args)...);
+    }
+    return &items[used++];
+  }
+
+  void reset() { used = 0; }
+  size_t size() { return used; }
+  size_t capacity() { return items.size(); }
+
+private:
+  std::deque<T> items;
+  size_t used = 0;
+};
+
+#endif
@@ -22,6 +22,7 @@ public:
   Region(Biom b, PointList v, HeightMap h, Point s);
   PointList getPoints();
   float getHeight(Point p);
+  int id = 0;
   Biom biom;
   Point site;
   bool hasRiver = false;
@@ -30,6 +31,7 @@ public:
   MegaCluster *megaCluster = nullptr;
   bool border = false;
   float humidity = 0.f;
+  float moisture = 0.f;
   Cell* cell = nullptr;
   float temperature = 0.f;
   float minerals = 0.f;
@@ -42,6 +44,9 @@ public:
   State* state = nullptr;
   bool stateBorder = false;
   bool seaBorder = false;
+  int coastDistance = 0;
+  int seaArea = 0;
+  float seaReach = 0.f;
 private:
 	PointList _verticies;
   HeightMap _heights;
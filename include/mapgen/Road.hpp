@@ -8,6 +8,9 @@
 class Road {
 public:
   Road(micropather::MPVector<void *>* path, float c);
+  Road(const Road &) = delete;
+  Road &operator=(const Road &) = delete;
+  ~Road();
   std::vector<Region *> regions;
   float cost;
   sw::Spline* spline = nullptr;
@@ -0,0 +1,37 @@
+#ifndef ROAD_NETWORK_H_
+#define ROAD_NETWORK_H_
+
+#include "City.hpp"
+#include <utility>
+
+// Sparse set of city pairs to connect with roads: a Euclidean minimum
+// spanning forest plus a shortcut wherever the detour over the network is
+// longer than ratio times the straight line. Cities on different land
+// masses are only linked port to port.
+class RoadNetwork {
+public:
+  RoadNetwork(std::vector<City *> c, float ratio);
+
+  std::vector<City *> cities;
+  std::vector<std::pair<City *, City *>> edges;
+  // Number of city pairs whose shortest route uses each edge.
+  std::vector<int> usage;
+
+private:
+  bool canLink(City *c, City *oc);
+  void addEdge(int i, int j, float d);
+  void shortest(int s, std::vector<float> &dist, std::vector<int> &prev);
+  float bounded(int s, int t, float limit);
+  void countUsage();
+
+  int size;
+  std::vector<std::pair<int, int>> links;
+  std::vector<float> lengths;
+  std::vector<std::vector<int>> adjacent;
+  // Scratch for bounded(), reset by generation.
+  std::vector<float> dist;
+  std::vector<int> stamp;
+  int generation = 0;
+};
+
+#endif
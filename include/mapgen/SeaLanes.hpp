@@ -0,0 +1,50 @@
+#ifndef SEA_LANES_H_
+#define SEA_LANES_H_
+
+#include "Region.hpp"
+#include "micropather.h"
+
+class Map;
+// Port-to-port lanes across each body of water. Every port runs one
+// Dijkstra through the water it touches, so a lane costs exactly what the
+// cheapest crossing through the water regions would. Once the map swaps its
+// water edges for lanes, searches never enter open water and expand() puts
+// the water regions back into finished paths. Lanes are only kept where
+// they beat a direct land edge between the two ports.
+class SeaLanes {
+public:
+  struct Lane {
+    Region *port;
+    float cost;
+    int sea;
+    int source;
+    int last;
+  };
+
+  SeaLanes(Map *m);
+  std::vector<Lane> &getOutgoing(Region *port);
+  std::vector<Lane> &getIncoming(Region *port);
+  bool hasLane(Region *from, Region *to);
+  // Appends the water regions strictly between two ports joined by a lane.
+  void expand(Region *from, Region *to, std::vector<void *> &path);
+  int getLaneCount();
+
+private:
+  struct Sea {
+    std::vector<Region *> regions;
+    // Per source port, the predecessor of each water region (local index,
+    // -1 next to the port).
+    std::vector<std::vector<int>> prev;
+  };
+  void cross(Map *map, Region *port, int s);
+  Lane *find(Region *from, Region *to);
+
+  std::vector<Sea> seas;
+  std::vector<int> seaOf;
+  std::vector<int> localOf;
+  std::vector<std::vector<Lane>> outgoing;
+  std::vector<std::vector<Lane>> incoming;
+  int laneCount = 0;
+};
+
+#endif
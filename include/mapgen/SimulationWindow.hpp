@@ -8,4 +8,13 @@ private:
 public:
   SimulationWindow(sf::RenderWindow *w, MapGenerator *m);
   void draw();
+  std::vector<EconomyVars> getBatchRuns();
+
+  int batchRuns = 100;
+  int batchVar = 0;
+  float batchFrom = 0.01f;
+  float batchTo = 0.1f;
+  int continueYears = 10;
+  // Snapshot picked in the UI; the application restores it and repaints.
+  int restoreIndex = -1;
 };
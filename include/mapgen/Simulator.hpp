@@ -3,21 +3,61 @@
 #include "mapgen/Map.hpp"
 #include "mapgen/Economy.hpp"
 #include "mapgen/Report.hpp"
+#include "mapgen/EconomyRun.hpp"
+#include "mapgen/Pool.hpp"
+#include <deque>
 #include <random>
 
+class Market;
+class TradeMatrix;
+class BatchSimulator;
+class ContractionHierarchy;
+class ClusterPather;
+class PathCache;
+// Timing and search counters for one road-building stage.
+struct StageStats {
+  std::string name;
+  float seconds = 0.f;
+  int queries = 0;
+  long expanded = 0;
+  long catchment = 0;
+  micropather::CacheData cache;
+};
+
 class Simulator{
 public:
   Simulator(Map* m, int s);
   void simulate();
   void resetAll();
+  void simulateBatch(std::vector<EconomyVars> runs);
+  void continueEconomy(int n);
+  void saveSnapshot();
+  bool restoreSnapshot(int i);
 
   int years = 50;
+  bool sparseRoads = false;
+  float detourRatio = 1.5f;
+  bool useHierarchy = false;
+  bool useClusters = false;
   EconomyVars* vars;
 
   Report* report;
+  BatchSimulator* batch;
+  // Built by makeRoads when useHierarchy is set; valid for that stage's
+  // edge costs.
+  ContractionHierarchy* hierarchy;
+  // Built by makeRoads when useClusters is set and useHierarchy is not.
+  ClusterPather* clusterPather;
+  // Shared by the makeRoads workers; kept for its statistics.
+  PathCache* pathCache;
+  std::vector<EconomySnapshot> snapshots;
+  // Filled by the road stages of the last simulate().
+  std::vector<StageStats> stats;
 
 private:
+  Pool<Road> &roadPool(int i);
   void makeRoads();
+  void applyTraffic(std::vector<std::vector<int>> &traffic);
   void makeCaves();
   void upgradeCities();
   void removeBadPorts();
@@ -28,8 +68,8 @@ private:
   void removeCities();
 
   void simulateEconomy();
-  void economyTick(int y);
-  void populationTick(int y);
+  void stepEconomy(int n);
+  void applyEconomy();
   void disasterTick(int y);
 
   template<typename Iter>
@@ -40,6 +80,13 @@ private:
   std::mt19937* _gen;
   int _seed;
   micropather::MicroPather* _pather;
+  Market* market;
+  TradeMatrix* trade;
+  EconomyRun* economy;
+
+  std::deque<Pool<Road>> roadPools;
+  Pool<Location> locationPool;
+  Pool<City> fortPool;
 };
 
 #endif
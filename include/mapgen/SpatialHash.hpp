@@ -0,0 +1,25 @@
+#ifndef SPATIAL_HASH_H_
+#define SPATIAL_HASH_H_
+
+#include "Region.hpp"
+#include <functional>
+#include <unordered_map>
+
+class SpatialHash {
+public:
+  SpatialHash(float cs);
+  void insert(Region *r);
+  bool hasNear(Point p, float radius);
+  bool hasNear(Point p, float radius, std::function<bool(Region *)> filter);
+  void clear();
+  int size();
+
+  float cellSize;
+
+private:
+  unsigned long long key(int x, int y);
+  std::unordered_map<unsigned long long, std::vector<Region *>> cells;
+  int count = 0;
+};
+
+#endif
@@ -1,14 +1,15 @@
 #ifndef STATE_H_
 #define STATE_H_
 #include <SFML/Graphics.hpp>
-#include <VoronoiDiagramGenerator.h>
 
+class Region;
 class State {
 public:
-  State(std::string n, sf::Color cl, Cell* c);
+  State(int i, std::string n, sf::Color cl, Region* c);
+  int id;
   std::string name;
   sf::Color color;
-  Cell* cell;
+  Region* center;
 };
 
 #endif
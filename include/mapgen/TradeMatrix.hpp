@@ -0,0 +1,33 @@
+#ifndef TRADE_MATRIX_H_
+#define TRADE_MATRIX_H_
+
+#include "City.hpp"
+
+struct PortRange {
+  City **first;
+  City **last;
+  City **begin() { return first; }
+  City **end() { return last; }
+};
+
+class TradeMatrix {
+public:
+  TradeMatrix(std::vector<City *> c, bool sparse);
+  float getPrice(City *buyer, City *seller);
+  PortRange getPorts(City *from, City *to);
+
+  std::vector<City *> cities;
+
+private:
+  int index(City *from, City *to);
+  City *other(Road *road, City *c);
+  bool listed(City *c);
+  void direct(City *from, std::vector<float> &cost, std::vector<Road *> &via);
+  void route(City *from, std::vector<float> &cost, std::vector<Road *> &via);
+  int size;
+  std::vector<float> prices;
+  std::vector<int> portOffsets;
+  std::vector<City *> ports;
+};
+
+#endif
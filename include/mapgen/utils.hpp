@@ -1,20 +1,85 @@
 #ifndef UTILS_HPP_
 #define UTILS_HPP_
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include "mapgen/City.hpp"
 
 typedef sf::Vector2<double>* Point;
 namespace mg {
-	template <typename T> using filterFunc = std::function<bool(T *)>;
-	template <typename T> using sortFunc = std::function<bool(T *, T *)>;
+  double getDistance(Point p, Point p2);
 
+  // Filter only, in input order; stops after `limit` matches.
+  template <typename T, typename F>
+  std::vector<T *> filterObjects(const std::vector<T *> &objects, F filter,
+                                 size_t limit = std::numeric_limits<size_t>::max()) {
+    std::vector<T *> result;
+    for (auto o : objects) {
+      if (result.size() >= limit) {
+        break;
+      }
+      if (filter(o)) {
+        result.push_back(o);
+      }
+    }
+    return result;
+  }
 
-  double getDistance(Point p, Point p2);
+  // Filter and keep the `k` elements with the largest `key`, best first.
+  // The key is evaluated once per candidate.
+  template <typename T, typename F, typename K>
+  std::vector<T *> topObjects(const std::vector<T *> &objects, F filter,
+                              K key, size_t k) {
+    std::vector<std::pair<float, T *>> scored;
+    for (auto o : objects) {
+      if (filter(o)) {
+        scored.push_back(std::make_pair(key(o), o));
+      }
+    }
+    k = std::min(k, scored.size());
+    auto byKey = [](const std::pair<float, T *> &a,
+                    const std::pair<float, T *> &b) {
+      return a.first > b.first;
+    };
+    if (k == scored.size()) {
+      std::sort(scored.begin(), scored.end(), byKey);
+    } else {
+      std::partial_sort(scored.begin(), scored.begin() + k, scored.end(),
+                        byKey);
+    }
+    std::vector<T *> result;
+    result.reserve(k);
+    for (size_t i = 0; i < k; i++) {
+      result.push_back(scored[i].second);
+    }
+    return result;
+  }
 
-  template <typename T>
-  std::vector<T *> filterObjects(std::vector<T *> regions,
-                                 std::function<bool(T *)> filter, std::function<bool(T *, T *)> sort);
+  // Visit filtered elements best first until `visit` returns false. For
+  // callers that skip some candidates and cannot know k up front; only the
+  // visited prefix is ordered (a heap, so ties come in no fixed order).
+  template <typename T, typename F, typename K, typename V>
+  void visitTopObjects(const std::vector<T *> &objects, F filter, K key,
+                       V visit) {
+    std::vector<std::pair<float, T *>> scored;
+    for (auto o : objects) {
+      if (filter(o)) {
+        scored.push_back(std::make_pair(key(o), o));
+      }
+    }
+    auto byKey = [](const std::pair<float, T *> &a,
+                    const std::pair<float, T *> &b) {
+      return a.first < b.first;
+    };
+    std::make_heap(scored.begin(), scored.end(), byKey);
+    for (auto end = scored.end(); end != scored.begin(); --end) {
+      std::pop_heap(scored.begin(), end, byKey);
+      if (!visit((end - 1)->second)) {
+        break;
+      }
+    }
+  }
 
   void before(std::string method);
   void after(std::string method);
@@ -0,0 +1,86 @@
+#include "mapgen/BatchSimulator.hpp"
+#include "mapgen/EconomyRun.hpp"
+#include "mapgen/utils.hpp"
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+void Distribution::update() {
+  if (values.size() == 0) {
+    return;
+  }
+  min = *std::min_element(values.begin(), values.end());
+  max = *std::max_element(values.begin(), values.end());
+  double sum = 0;
+  for (auto v : values) {
+    sum += v;
+  }
+  mean = sum / values.size();
+  double d = 0;
+  for (auto v : values) {
+    d += (v - mean) * (v - mean);
+  }
+  deviation = std::sqrt(d / values.size());
+}
+
+std::vector<float> Distribution::histogram(int bins) {
+  std::vector<float> h(bins, 0.f);
+  if (values.size() == 0) {
+    return h;
+  }
+  float w = (max - min) / bins;
+  for (auto v : values) {
+    int b = w > 0 ? int((v - min) / w) : 0;
+    h[std::min(b, bins - 1)]++;
+  }
+  return h;
+}
+
+BatchSimulator::BatchSimulator(Market *m, TradeMatrix *t, int s)
+    : market(m), trade(t), seed(s) {}
+
+std::vector<EconomyVars> BatchSimulator::sweep(EconomyVars base,
+                                               float EconomyVars::*field,
+                                               float from, float to,
+                                               int count) {
+  std::vector<EconomyVars> runs(count, base);
+  for (int i = 0; i < count; i++) {
+    float k = count > 1 ? float(i) / (count - 1) : 0.f;
+    runs[i].*field = from + (to - from) * k;
+  }
+  return runs;
+}
+
+void BatchSimulator::run(std::vector<EconomyVars> runs, int years) {
+  vars = runs;
+  reports.assign(runs.size(), Report());
+  population.values.assign(runs.size(), 0.f);
+  wealth.values.assign(runs.size(), 0.f);
+
+  int n = threads > 0 ? threads : std::thread::hardware_concurrency();
+  n = std::max(1, std::min(n, int(runs.size())));
+  std::atomic<int> next(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < n; t++) {
+    workers.push_back(std::thread([&]() {
+      int i;
+      while ((i = next++) < int(vars.size())) {
+        EconomyRun r(market, trade, vars[i], seed + i);
+        r.run(years);
+        if (years > 0) {
+          population.values[i] = r.report.population.back();
+          wealth.values[i] = r.report.wealth.back();
+        }
+        reports[i] = std::move(r.report);
+      }
+    }));
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  population.update();
+  wealth.update();
+  mg::info("Batch runs:", int(runs.size()));
+  mg::info("Batch mean population:", int(population.mean));
+}
@@ -0,0 +1,119 @@
+#include "mapgen/BidirectionalSearch.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+const float UNREACHED = std::numeric_limits<float>::max();
+
+BidirectionalSearch::BidirectionalSearch(Map *m) : map(m) {
+  int n = map->regions.size();
+  stamp.assign(n, 0);
+  potential.assign(n, 0.f);
+  for (int side = 0; side < 2; side++) {
+    g[side].assign(n, UNREACHED);
+    prev[side].assign(n, -1);
+    closed[side].assign(n, false);
+  }
+}
+
+void BidirectionalSearch::touch(int v) {
+  if (stamp[v] == generation) {
+    return;
+  }
+  stamp[v] = generation;
+  Region *r = map->regions[v];
+  potential[v] = 0.5f * (map->LeastCostEstimate(r, target) -
+                         map->LeastCostEstimate(source, r));
+  for (int side = 0; side < 2; side++) {
+    g[side][v] = UNREACHED;
+    prev[side][v] = -1;
+    closed[side][v] = false;
+  }
+}
+
+void BidirectionalSearch::push(int side, float key, int v) {
+  open[side].push_back(std::make_pair(key, v));
+  std::push_heap(open[side].begin(), open[side].end(), std::greater<Item>());
+}
+
+BidirectionalSearch::Item BidirectionalSearch::pop(int side) {
+  std::pop_heap(open[side].begin(), open[side].end(), std::greater<Item>());
+  Item top = open[side].back();
+  open[side].pop_back();
+  return top;
+}
+
+// The forward search keys regions by g + p and the backward one by g - p,
+// which gives both the same non-negative reduced edge costs. Once the two
+// smallest keys add up to the best meeting cost nothing shorter is left.
+bool BidirectionalSearch::getPath(Region *from, Region *to,
+                                  micropather::MPVector<void *> *path,
+                                  float *cost) {
+  path->clear();
+  generation++;
+  source = from;
+  target = to;
+  int s = from->id;
+  int t = to->id;
+  for (int side = 0; side < 2; side++) {
+    open[side].clear();
+  }
+  touch(s);
+  touch(t);
+  g[0][s] = 0.f;
+  g[1][t] = 0.f;
+  push(0, potential[s], s);
+  push(1, -potential[t], t);
+
+  float best = s == t ? 0.f : UNREACHED;
+  int meet = s == t ? s : -1;
+  while (!open[0].empty() && !open[1].empty() &&
+         open[0].front().first + open[1].front().first < best) {
+    int side = open[0].size() <= open[1].size() ? 0 : 1;
+    int u = pop(side).second;
+    if (closed[side][u]) {
+      continue;
+    }
+    closed[side][u] = true;
+    expanded++;
+
+    adjacent.clear();
+    if (side == 0) {
+      map->AdjacentCost(map->regions[u], &adjacent);
+    } else {
+      map->IncomingCost(map->regions[u], &adjacent);
+    }
+    float sign = side == 0 ? 1.f : -1.f;
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      int v = ((Region *)adjacent[i].state)->id;
+      touch(v);
+      float c = g[side][u] + adjacent[i].cost;
+      if (closed[side][v] || c >= g[side][v]) {
+        continue;
+      }
+      g[side][v] = c;
+      prev[side][v] = u;
+      push(side, c + sign * potential[v], v);
+      if (g[1 - side][v] != UNREACHED && c + g[1 - side][v] < best) {
+        best = c + g[1 - side][v];
+        meet = v;
+      }
+    }
+  }
+  if (meet == -1) {
+    return false;
+  }
+
+  std::vector<int> reversed;
+  for (int v = meet; v != -1; v = prev[0][v]) {
+    reversed.push_back(v);
+  }
+  for (auto it = reversed.rbegin(); it != reversed.rend(); ++it) {
+    path->push_back(map->regions[*it]);
+  }
+  for (int v = prev[1][meet]; v != -1; v = prev[1][v]) {
+    path->push_back(map->regions[v]);
+  }
+  *cost = best;
+  return true;
+}
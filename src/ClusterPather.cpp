@@ -0,0 +1,320 @@
+#include "mapgen/ClusterPather.hpp"
+#include "mapgen/utils.hpp"
+#include <limits>
+#include <map>
+#include <queue>
+#include <unordered_map>
+
+const float UNREACHED = std::numeric_limits<float>::max();
+const int PORTALS_PER_BORDER = 6;
+const float PORTAL_SPACING = 30.f;
+
+typedef std::pair<float, int> Item;
+typedef std::priority_queue<Item, std::vector<Item>, std::greater<Item>> Queue;
+
+struct BorderEdge {
+  float cost;
+  int from;
+  int to;
+};
+
+ClusterPather::ClusterPather(Map *m)
+    : map(m), size(m->regions.size()), out(size), in(size),
+      clusterOf(size, -1), portalOf(size, -1) {
+  std::unordered_map<Cluster *, int> index;
+  for (auto r : map->regions) {
+    auto it = index.find(r->cluster);
+    if (it == index.end()) {
+      it = index.insert(std::make_pair(r->cluster, int(index.size()))).first;
+    }
+    clusterOf[r->id] = it->second;
+  }
+  clusterPortals.resize(index.size());
+
+  std::map<std::pair<int, int>, std::vector<BorderEdge>> borders;
+  MP_VECTOR<micropather::StateCost> adjacent;
+  for (auto r : map->regions) {
+    adjacent.clear();
+    map->AdjacentCost(r, &adjacent);
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      int n = ((Region *)adjacent[i].state)->id;
+      out[r->id].push_back(std::make_pair(n, adjacent[i].cost));
+      in[n].push_back(std::make_pair(r->id, adjacent[i].cost));
+      if (clusterOf[n] != clusterOf[r->id]) {
+        borders[std::make_pair(clusterOf[r->id], clusterOf[n])].push_back(
+            {adjacent[i].cost, r->id, n});
+      }
+    }
+  }
+
+  auto portal = [&](int r) {
+    if (portalOf[r] == -1) {
+      portalOf[r] = portals.size();
+      portals.push_back(r);
+      clusterPortals[clusterOf[r]].push_back(portalOf[r]);
+      abstract.emplace_back();
+    }
+    return portalOf[r];
+  };
+
+  // Cheapest border edges first, spread out along the border.
+  for (auto &b : borders) {
+    auto &edges = b.second;
+    std::sort(edges.begin(), edges.end(),
+              [](const BorderEdge &e, const BorderEdge &e2) {
+                return e.cost < e2.cost;
+              });
+    std::vector<int> chosen;
+    for (auto &e : edges) {
+      if ((int)chosen.size() >= PORTALS_PER_BORDER) {
+        break;
+      }
+      bool near = false;
+      for (int c : chosen) {
+        if (mg::getDistance(map->regions[c]->site,
+                            map->regions[e.from]->site) < PORTAL_SPACING) {
+          near = true;
+          break;
+        }
+      }
+      if (near) {
+        continue;
+      }
+      chosen.push_back(e.from);
+      int p = portal(e.from);
+      int q = portal(e.to);
+      abstract[p].push_back(std::make_pair(q, e.cost));
+    }
+  }
+
+  Query query(this);
+  std::vector<int> targets;
+  for (auto &cluster : clusterPortals) {
+    targets.clear();
+    for (int p : cluster) {
+      targets.push_back(portals[p]);
+    }
+    for (int p : cluster) {
+      query.local(portals[p], out, targets);
+      for (int q : cluster) {
+        int r = portals[q];
+        if (q != p && query.stamp[r] == query.generation &&
+            query.dist[r] != UNREACHED) {
+          abstract[p].push_back(std::make_pair(q, query.dist[r]));
+        }
+      }
+    }
+  }
+  mg::info("Cluster portals:", int(portals.size()));
+}
+
+ClusterPather::Query::Query(ClusterPather *p)
+    : dist(p->size, UNREACHED), prev(p->size, -1), stamp(p->size, 0),
+      wanted(p->size, 0), cp(p) {}
+
+void ClusterPather::Query::touch(int v) {
+  if (stamp[v] != generation) {
+    stamp[v] = generation;
+    dist[v] = UNREACHED;
+    prev[v] = -1;
+  }
+}
+
+void ClusterPather::Query::local(int s, Graph &graph,
+                                 const std::vector<int> &targets) {
+  generation++;
+  int cluster = cp->clusterOf[s];
+  int left = 0;
+  for (int v : targets) {
+    if (wanted[v] != generation) {
+      wanted[v] = generation;
+      left++;
+    }
+  }
+  Queue queue;
+  touch(s);
+  dist[s] = 0.f;
+  queue.push(std::make_pair(0.f, s));
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    int u = top.second;
+    if (top.first > dist[u]) {
+      continue;
+    }
+    expanded++;
+    if (wanted[u] == generation && --left == 0) {
+      return;
+    }
+    for (auto &e : graph[u]) {
+      if (cp->clusterOf[e.first] != cluster) {
+        continue;
+      }
+      touch(e.first);
+      float c = top.first + e.second;
+      if (c < dist[e.first]) {
+        dist[e.first] = c;
+        prev[e.first] = u;
+        queue.push(std::make_pair(c, e.first));
+      }
+    }
+  }
+}
+
+// Appends the regions after a on the path a -> b: a border step or an
+// in-cluster path.
+bool ClusterPather::Query::refine(int a, int b, std::vector<int> &nodes) {
+  if (cp->clusterOf[a] != cp->clusterOf[b]) {
+    nodes.push_back(b);
+    return true;
+  }
+  local(a, cp->out, {b});
+  if (stamp[b] != generation || dist[b] == UNREACHED) {
+    return false;
+  }
+  size_t first = nodes.size();
+  for (int v = b; v != a; v = prev[v]) {
+    nodes.push_back(v);
+  }
+  std::reverse(nodes.begin() + first, nodes.end());
+  return true;
+}
+
+// A* over the portals plus two temporary nodes for the endpoints: start
+// links to the portals of its cluster, portals of the goal's cluster link
+// to goal, and a shared cluster also gets the direct in-cluster route.
+bool ClusterPather::Query::getPath(Region *from, Region *to,
+                                   micropather::MPVector<void *> *path,
+                                   float *cost) {
+  path->clear();
+  int s = from->id;
+  int t = to->id;
+  int n = cp->portals.size();
+  int start = n;
+  int goal = n + 1;
+
+  std::vector<std::pair<int, float>> startEdges;
+  std::vector<int> targets;
+  for (int p : cp->clusterPortals[cp->clusterOf[s]]) {
+    targets.push_back(cp->portals[p]);
+  }
+  if (cp->clusterOf[s] == cp->clusterOf[t]) {
+    targets.push_back(t);
+  }
+  local(s, cp->out, targets);
+  for (int p : cp->clusterPortals[cp->clusterOf[s]]) {
+    int r = cp->portals[p];
+    if (stamp[r] == generation && dist[r] != UNREACHED) {
+      startEdges.push_back(std::make_pair(p, dist[r]));
+    }
+  }
+  if (cp->clusterOf[s] == cp->clusterOf[t] && stamp[t] == generation &&
+      dist[t] != UNREACHED) {
+    startEdges.push_back(std::make_pair(goal, dist[t]));
+  }
+  targets.clear();
+  for (int p : cp->clusterPortals[cp->clusterOf[t]]) {
+    targets.push_back(cp->portals[p]);
+  }
+  local(t, cp->in, targets);
+  std::vector<float> goalCost(n, UNREACHED);
+  for (int p : cp->clusterPortals[cp->clusterOf[t]]) {
+    int r = cp->portals[p];
+    if (stamp[r] == generation) {
+      goalCost[p] = dist[r];
+    }
+  }
+
+  adist.assign(n + 2, UNREACHED);
+  aprev.assign(n + 2, -1);
+  auto region = [&](int v) {
+    return v == start ? from : (v == goal ? to : cp->map->regions[cp->portals[v]]);
+  };
+  Queue queue;
+  adist[start] = 0.f;
+  queue.push(std::make_pair(cp->map->LeastCostEstimate(from, to), start));
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    int u = top.second;
+    if (u == goal) {
+      break;
+    }
+    float h = cp->map->LeastCostEstimate(region(u), to);
+    if (top.first > adist[u] + h) {
+      continue;
+    }
+    expanded++;
+    auto relax = [&](int v, float c) {
+      c += adist[u];
+      if (c < adist[v]) {
+        adist[v] = c;
+        aprev[v] = u;
+        queue.push(std::make_pair(c + cp->map->LeastCostEstimate(region(v), to),
+                                  v));
+      }
+    };
+    if (u == start) {
+      for (auto &e : startEdges) {
+        relax(e.first, e.second);
+      }
+      continue;
+    }
+    for (auto &e : cp->abstract[u]) {
+      relax(e.first, e.second);
+    }
+    if (goalCost[u] != UNREACHED) {
+      relax(goal, goalCost[u]);
+    }
+  }
+  if (adist[goal] == UNREACHED) {
+    return false;
+  }
+
+  std::vector<int> corridor;
+  for (int v = goal; v != -1; v = aprev[v]) {
+    corridor.push_back(region(v)->id);
+  }
+  std::reverse(corridor.begin(), corridor.end());
+
+  std::vector<int> nodes(1, s);
+  float total = 0.f;
+  for (size_t i = 1; i < corridor.size(); i++) {
+    if (corridor[i] == corridor[i - 1]) {
+      continue;
+    }
+    if (!refine(corridor[i - 1], corridor[i], nodes)) {
+      return false;
+    }
+  }
+
+  // Segments refined one cluster at a time can pass the same region twice;
+  // the loop between the two visits is cut out.
+  std::unordered_map<int, size_t> at;
+  size_t kept = 0;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    auto it = at.find(nodes[i]);
+    if (it != at.end()) {
+      while (kept > it->second + 1) {
+        at.erase(nodes[--kept]);
+      }
+      continue;
+    }
+    at[nodes[i]] = kept;
+    nodes[kept++] = nodes[i];
+  }
+  nodes.resize(kept);
+  for (size_t i = 0; i < nodes.size(); i++) {
+    if (i > 0) {
+      for (auto &e : cp->out[nodes[i - 1]]) {
+        if (e.first == nodes[i]) {
+          total += e.second;
+          break;
+        }
+      }
+    }
+    path->push_back(cp->map->regions[nodes[i]]);
+  }
+  *cost = total;
+  return true;
+}
@@ -0,0 +1,351 @@
+#include "mapgen/ContractionHierarchy.hpp"
+#include "mapgen/utils.hpp"
+#include <limits>
+#include <queue>
+
+const float UNREACHED = std::numeric_limits<float>::max();
+const int WITNESS_SETTLED = 60;
+
+typedef std::pair<float, int> Item;
+typedef std::priority_queue<Item, std::vector<Item>, std::greater<Item>> Queue;
+
+ContractionHierarchy::ContractionHierarchy(Map *m)
+    : map(m), size(m->regions.size()), rank(size, -1), out(size), in(size),
+      up(size), down(size), contracted(size, false),
+      witnessCost(size, UNREACHED), witnessStamp(size, 0) {
+  MP_VECTOR<micropather::StateCost> adjacent;
+  for (auto r : map->regions) {
+    adjacent.clear();
+    map->AdjacentCost(r, &adjacent);
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      addEdge(r->id, ((Region *)adjacent[i].state)->id, adjacent[i].cost, -1);
+    }
+  }
+
+  // Lazy edge-difference ordering: a popped region is contracted only if
+  // its refreshed priority still beats the next one in the queue.
+  std::vector<int> deleted(size, 0);
+  auto priority = [&](int v) {
+    return countShortcuts(v, false) - int(in[v].size() + out[v].size()) +
+           deleted[v];
+  };
+  std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
+                      std::greater<std::pair<int, int>>>
+      order;
+  for (int v = 0; v < size; v++) {
+    order.push(std::make_pair(priority(v), v));
+  }
+  int next = 0;
+  while (!order.empty()) {
+    int v = order.top().second;
+    order.pop();
+    if (contracted[v]) {
+      continue;
+    }
+    int p = priority(v);
+    if (!order.empty() && p > order.top().first) {
+      order.push(std::make_pair(p, v));
+      continue;
+    }
+    shortcuts += countShortcuts(v, true);
+    contracted[v] = true;
+    rank[v] = next++;
+    for (auto &e : in[v]) {
+      deleted[e.node]++;
+    }
+    for (auto &e : out[v]) {
+      deleted[e.node]++;
+    }
+  }
+
+  for (int v = 0; v < size; v++) {
+    for (auto &e : out[v]) {
+      if (rank[e.node] > rank[v]) {
+        up[v].push_back(e);
+      }
+    }
+    for (auto &e : in[v]) {
+      if (rank[e.node] > rank[v]) {
+        down[v].push_back(e);
+      }
+    }
+  }
+  out.clear();
+  in.clear();
+  mg::info("Hierarchy shortcuts:", shortcuts);
+}
+
+// Keeps at most one edge per ordered pair, the cheapest.
+void ContractionHierarchy::addEdge(int u, int x, float c, int m) {
+  for (auto &e : out[u]) {
+    if (e.node == x) {
+      if (c < e.cost) {
+        e.cost = c;
+        e.middle = m;
+        for (auto &ie : in[x]) {
+          if (ie.node == u) {
+            ie.cost = c;
+            ie.middle = m;
+          }
+        }
+      }
+      return;
+    }
+  }
+  out[u].push_back({x, c, m});
+  in[x].push_back({u, c, m});
+}
+
+// Bounded Dijkstra from u over uncontracted regions, skipping v.
+void ContractionHierarchy::witness(int u, int v, float limit) {
+  witnessGeneration++;
+  Queue queue;
+  witnessStamp[u] = witnessGeneration;
+  witnessCost[u] = 0.f;
+  queue.push(std::make_pair(0.f, u));
+  int settled = 0;
+  while (!queue.empty() && settled < WITNESS_SETTLED) {
+    auto top = queue.top();
+    queue.pop();
+    int a = top.second;
+    if (top.first > witnessCost[a]) {
+      continue;
+    }
+    if (top.first > limit) {
+      break;
+    }
+    settled++;
+    for (auto &e : out[a]) {
+      if (e.node == v || contracted[e.node]) {
+        continue;
+      }
+      float c = top.first + e.cost;
+      if (witnessStamp[e.node] != witnessGeneration ||
+          c < witnessCost[e.node]) {
+        witnessStamp[e.node] = witnessGeneration;
+        witnessCost[e.node] = c;
+        queue.push(std::make_pair(c, e.node));
+      }
+    }
+  }
+}
+
+// Shortcuts needed to contract v; added to the graph when contract is set.
+int ContractionHierarchy::countShortcuts(int v, bool contract) {
+  int n = 0;
+  float maxOut = 0.f;
+  for (auto &e : out[v]) {
+    if (!contracted[e.node]) {
+      maxOut = std::max(maxOut, e.cost);
+    }
+  }
+  for (auto inEdge : in[v]) {
+    int u = inEdge.node;
+    if (contracted[u]) {
+      continue;
+    }
+    witness(u, v, inEdge.cost + maxOut);
+    for (auto outEdge : out[v]) {
+      int x = outEdge.node;
+      if (x == u || contracted[x]) {
+        continue;
+      }
+      float c = inEdge.cost + outEdge.cost;
+      if (witnessStamp[x] == witnessGeneration && witnessCost[x] <= c) {
+        continue;
+      }
+      n++;
+      if (contract) {
+        addEdge(u, x, c, v);
+      }
+    }
+  }
+  return n;
+}
+
+ContractionHierarchy::Edge *ContractionHierarchy::findEdge(int a, int b) {
+  auto &edges = rank[a] < rank[b] ? up[a] : down[b];
+  int other = rank[a] < rank[b] ? b : a;
+  for (auto &e : edges) {
+    if (e.node == other) {
+      return &e;
+    }
+  }
+  return nullptr;
+}
+
+// Appends the regions after a on the original path a -> b.
+void ContractionHierarchy::unpack(int a, int b, std::vector<int> &nodes) {
+  Edge *e = findEdge(a, b);
+  if (e == nullptr || e->middle == -1) {
+    nodes.push_back(b);
+    return;
+  }
+  int m = e->middle;
+  unpack(a, m, nodes);
+  unpack(m, b, nodes);
+}
+
+ContractionHierarchy::Query::Query(ContractionHierarchy *h)
+    : ch(h), stamp(h->size, 0), buckets(h->size) {
+  for (int d = 0; d < 2; d++) {
+    dist[d].assign(ch->size, UNREACHED);
+    parent[d].assign(ch->size, -1);
+  }
+}
+
+void ContractionHierarchy::Query::touch(int v) {
+  if (stamp[v] != generation) {
+    stamp[v] = generation;
+    dist[0][v] = dist[1][v] = UNREACHED;
+    parent[0][v] = parent[1][v] = -1;
+  }
+}
+
+// Bidirectional upward Dijkstra; returns the meeting region or -1.
+int ContractionHierarchy::Query::search(int s, int t) {
+  generation++;
+  Queue queue[2];
+  std::vector<std::vector<Edge>> *graph[2] = {&ch->up, &ch->down};
+  touch(s);
+  touch(t);
+  dist[0][s] = 0.f;
+  dist[1][t] = 0.f;
+  queue[0].push(std::make_pair(0.f, s));
+  queue[1].push(std::make_pair(0.f, t));
+  float best = UNREACHED;
+  int meet = -1;
+  if (s == t) {
+    return s;
+  }
+  while (!queue[0].empty() || !queue[1].empty()) {
+    for (int d = 0; d < 2; d++) {
+      if (queue[d].empty()) {
+        continue;
+      }
+      auto top = queue[d].top();
+      queue[d].pop();
+      int v = top.second;
+      if (top.first > dist[d][v]) {
+        continue;
+      }
+      if (top.first >= best) {
+        queue[d] = Queue();
+        continue;
+      }
+      expanded++;
+      if (dist[1 - d][v] != UNREACHED && top.first + dist[1 - d][v] < best) {
+        best = top.first + dist[1 - d][v];
+        meet = v;
+      }
+      for (auto &e : (*graph[d])[v]) {
+        touch(e.node);
+        float c = top.first + e.cost;
+        if (c < dist[d][e.node]) {
+          dist[d][e.node] = c;
+          parent[d][e.node] = v;
+          queue[d].push(std::make_pair(c, e.node));
+        }
+      }
+    }
+  }
+  return meet;
+}
+
+float ContractionHierarchy::Query::getCost(Region *from, Region *to) {
+  int m = search(from->id, to->id);
+  if (m == -1) {
+    return UNREACHED;
+  }
+  return dist[0][m] + dist[1][m];
+}
+
+bool ContractionHierarchy::Query::getPath(Region *from, Region *to,
+                                          micropather::MPVector<void *> *path,
+                                          float *cost) {
+  path->clear();
+  int m = search(from->id, to->id);
+  if (m == -1) {
+    return false;
+  }
+  *cost = dist[0][m] + dist[1][m];
+
+  std::vector<int> chain;
+  for (int v = m; v != -1; v = parent[0][v]) {
+    chain.push_back(v);
+  }
+  std::reverse(chain.begin(), chain.end());
+  for (int v = parent[1][m]; v != -1; v = parent[1][v]) {
+    chain.push_back(v);
+  }
+
+  std::vector<int> nodes(1, chain[0]);
+  for (size_t i = 1; i < chain.size(); i++) {
+    ch->unpack(chain[i - 1], chain[i], nodes);
+  }
+  for (int v : nodes) {
+    path->push_back(ch->map->regions[v]);
+  }
+  return true;
+}
+
+// Full upward search from s; settled regions are returned in order.
+void ContractionHierarchy::Query::upward(int s,
+                                         std::vector<std::vector<Edge>> &graph,
+                                         std::vector<int> &settled) {
+  generation++;
+  settled.clear();
+  Queue queue;
+  touch(s);
+  dist[0][s] = 0.f;
+  queue.push(std::make_pair(0.f, s));
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    int v = top.second;
+    if (top.first > dist[0][v]) {
+      continue;
+    }
+    settled.push_back(v);
+    for (auto &e : graph[v]) {
+      touch(e.node);
+      float c = top.first + e.cost;
+      if (c < dist[0][e.node]) {
+        dist[0][e.node] = c;
+        queue.push(std::make_pair(c, e.node));
+      }
+    }
+  }
+}
+
+// Bucket many-to-many: one backward search per target fills buckets, one
+// forward search per source scans them.
+std::vector<float>
+ContractionHierarchy::Query::getTable(const std::vector<Region *> &from,
+                                      const std::vector<Region *> &to) {
+  std::vector<float> table(from.size() * to.size(), UNREACHED);
+  std::vector<int> settled;
+  std::vector<int> used;
+  for (size_t j = 0; j < to.size(); j++) {
+    upward(to[j]->id, ch->down, settled);
+    for (int v : settled) {
+      if (buckets[v].empty()) {
+        used.push_back(v);
+      }
+      buckets[v].push_back(std::make_pair(j, dist[0][v]));
+    }
+  }
+  for (size_t i = 0; i < from.size(); i++) {
+    upward(from[i]->id, ch->up, settled);
+    float *row = &table[i * to.size()];
+    for (int v : settled) {
+      for (auto &b : buckets[v]) {
+        row[b.first] = std::min(row[b.first], dist[0][v] + b.second);
+      }
+    }
+  }
+  for (int v : used) {
+    buckets[v].clear();
+  }
+  return table;
+}
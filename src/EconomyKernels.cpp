@@ -0,0 +1,50 @@
+#include "mapgen/EconomyKernels.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace kernels {
+
+void growPopulation(int *population, const float *wealth, int n, float grows,
+                    float modifier) {
+  for (int i = 0; i < n; i++) {
+    int p = population[i] * (float)(1 + grows * wealth[i] * modifier);
+    population[i] = std::max(p, 0);
+  }
+}
+
+template <typename T> Reduction<T> reduce(const T *values, int n, T skip) {
+  T sum[LANES];
+  T mn[LANES];
+  T mx[LANES];
+  std::fill(sum, sum + LANES, 0);
+  std::fill(mn, mn + LANES, std::numeric_limits<T>::max());
+  std::fill(mx, mx + LANES, std::numeric_limits<T>::lowest());
+
+  int i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    for (int j = 0; j < LANES; j++) {
+      T v = values[i + j];
+      sum[j] += v;
+      mx[j] = std::max(mx[j], v);
+      mn[j] = std::min(mn[j], v == skip ? mn[j] : v);
+    }
+  }
+  for (; i < n; i++) {
+    T v = values[i];
+    sum[0] += v;
+    mx[0] = std::max(mx[0], v);
+    mn[0] = std::min(mn[0], v == skip ? mn[0] : v);
+  }
+
+  Reduction<T> r = {sum[0], mn[0], mx[0]};
+  for (int j = 1; j < LANES; j++) {
+    r.sum += sum[j];
+    r.min = std::min(r.min, mn[j]);
+    r.max = std::max(r.max, mx[j]);
+  }
+  return r;
+}
+
+template Reduction<int> reduce<int>(const int *, int, int);
+template Reduction<float> reduce<float>(const float *, int, float);
+} // namespace kernels
@@ -0,0 +1,233 @@
+#include "mapgen/EconomyRun.hpp"
+#include "mapgen/EconomyKernels.hpp"
+#include "mapgen/utils.hpp"
+#include <cstring>
+#include <numeric>
+
+EconomyRun::EconomyRun(Market *m, TradeMatrix *t, EconomyVars v,
+                       unsigned int s)
+    : vars(v), market(m), trade(t), seed(s), order(m->cities) {
+  reset();
+}
+
+template <typename T> void put(std::vector<char> &data, const T &v) {
+  auto p = reinterpret_cast<const char *>(&v);
+  data.insert(data.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+void put(std::vector<char> &data, const std::vector<T> &v) {
+  put(data, (int)v.size());
+  auto p = reinterpret_cast<const char *>(v.data());
+  data.insert(data.end(), p, p + sizeof(T) * v.size());
+}
+
+template <typename T> bool get(const char *&p, const char *end, T &v) {
+  if (end - p < (long)sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&v, p, sizeof(T));
+  p += sizeof(T);
+  return true;
+}
+
+template <typename T>
+bool get(const char *&p, const char *end, std::vector<T> &v) {
+  int n;
+  if (!get(p, end, n) || n < 0 || (end - p) / (long)sizeof(T) < n) {
+    return false;
+  }
+  v.resize(n);
+  std::memcpy(v.data(), p, sizeof(T) * n);
+  p += sizeof(T) * n;
+  return true;
+}
+
+void EconomyRun::reset() {
+  int n = market->cities.size();
+  population.assign(n, Economy::INITIAL_POPULATION);
+  wealth.assign(n, Economy::INITIAL_WEALTH);
+  book[MINERALS].assign(n, nullptr);
+  book[AGROCULTURE].assign(n, nullptr);
+  report = Report();
+  year = 0;
+}
+
+void EconomyRun::run(int years) {
+  for (int y = 0; y < years; y++) {
+    step();
+  }
+}
+
+// Every year reseeds from (seed, year) and reshuffles the cities from the
+// market order, so a snapshot does not need the generator state. Both
+// values go through seed_seq so run i in year y+1 does not replay run i+1
+// in year y.
+void EconomyRun::step() {
+  year++;
+  std::seed_seq seq{seed, (unsigned int)year};
+  gen.seed(seq);
+  economyTick();
+  populationTick();
+}
+
+EconomySnapshot EconomyRun::snapshot() {
+  EconomySnapshot s;
+  s.year = year;
+  put(s.data, (int)population.size());
+  put(s.data, report.minPopulation);
+  put(s.data, report.maxPopulation);
+  put(s.data, report.minWealth);
+  put(s.data, report.maxWealth);
+  put(s.data, report.population);
+  put(s.data, report.wealth);
+  put(s.data, population);
+  put(s.data, wealth);
+  return s;
+}
+
+// The snapshot is read into temporaries and only applied once the whole
+// buffer has been checked.
+bool EconomyRun::restore(const EconomySnapshot &s) {
+  const char *p = s.data.data();
+  const char *end = p + s.data.size();
+  int n;
+  if (!get(p, end, n)) {
+    mg::warn("Snapshot is truncated, bytes:", (int)s.data.size());
+    return false;
+  }
+  if (n != (int)market->cities.size()) {
+    mg::warn("Snapshot is from another map, cities:", n);
+    return false;
+  }
+  Report r;
+  std::vector<int> pop;
+  std::vector<float> w;
+  if (!get(p, end, r.minPopulation) || !get(p, end, r.maxPopulation) ||
+      !get(p, end, r.minWealth) || !get(p, end, r.maxWealth) ||
+      !get(p, end, r.population) || !get(p, end, r.wealth) ||
+      !get(p, end, pop) || !get(p, end, w) || p != end ||
+      (int)pop.size() != n || (int)w.size() != n) {
+    mg::warn("Snapshot is corrupt, bytes:", (int)s.data.size());
+    return false;
+  }
+  reset();
+  year = s.year;
+  report = r;
+  population = pop;
+  wealth = w;
+  return true;
+}
+
+Package *EconomyRun::makeGoods(City *c) {
+  unsigned int p;
+  switch (c->type) {
+  case AGRO:
+    p = c->region->nice * vars.PACKAGES_PER_NICE * population[c->id] *
+        vars.PACKAGES_AGRO_POPULATION_MODIFIER;
+    return packages.make(c, AGROCULTURE, p);
+  case MINE:
+    p = c->region->minerals * vars.PACKAGES_PER_MINERALS * population[c->id] *
+        vars.PACKAGES_MINERALS_POPULATION_MODIFIER;
+    return packages.make(c, MINERALS, p);
+  }
+  return nullptr;
+}
+
+unsigned int EconomyRun::buyGoods(City *c) {
+  int i = c->id;
+  unsigned int mineralsNeeded =
+      population[i] * (vars.CONSUME_MINERALS_POPULATION_MODIFIER -
+                       c->region->minerals * vars.MINERALS_POPULATION_PRODUCE);
+  unsigned int agroNeeded =
+      population[i] * (vars.CONSUME_AGRO_POPULATION_MODIFIER -
+                       c->region->nice * vars.AGRO_POPULATION_PRODUCE);
+
+  agroNeeded = buy(c, AGROCULTURE, agroNeeded);
+  mineralsNeeded = buy(c, MINERALS, mineralsNeeded);
+
+  wealth[i] -= vars.CANT_BUY_AGRO * agroNeeded / (float)population[i];
+  wealth[i] -= vars.CANT_BUY_MINERALS * mineralsNeeded / (float)population[i];
+  wealth[i] = std::max(wealth[i], 0.f);
+  return agroNeeded + mineralsNeeded;
+}
+
+unsigned int EconomyRun::buy(City *buyer, PackageType type,
+                             unsigned int needed) {
+  for (auto seller : market->getSuppliers(buyer, type)) {
+    if (needed == 0) {
+      break;
+    }
+    auto p = book[type][seller->id];
+    if (p == nullptr || p->count == 0) {
+      continue;
+    }
+    unsigned int c = std::min(needed, p->count);
+    needed -= c;
+    sell(p, buyer, trade->getPrice(buyer, seller), c);
+  }
+  return needed;
+}
+
+void EconomyRun::sell(Package *p, City *buyer, float price, unsigned int c) {
+  int o = p->owner->id;
+  int b = buyer->id;
+  p->count -= c;
+  wealth[o] += price / (float)population[o] * c;
+  wealth[o] = std::max(wealth[o], 0.f);
+
+  wealth[b] -= price / (float)population[b] * c;
+  wealth[b] = std::max(wealth[b], 0.f);
+  for (auto port : trade->getPorts(buyer, p->owner)) {
+    wealth[port->id] += price * vars.PORT_FEE / population[port->id] * c;
+  }
+}
+
+void EconomyRun::economyTick() {
+  if (verbose) {
+    mg::info("Economy year:", year * 10);
+  }
+  packages.reset();
+  goods.clear();
+  std::fill(book[MINERALS].begin(), book[MINERALS].end(), nullptr);
+  std::fill(book[AGROCULTURE].begin(), book[AGROCULTURE].end(), nullptr);
+  for (auto c : order) {
+    auto lg = makeGoods(c);
+    if (lg != nullptr) {
+      goods.push_back(lg);
+      book[lg->type][c->id] = lg;
+    }
+  }
+  if (verbose) {
+    unsigned int gc =
+        std::accumulate(goods.begin(), goods.end(), 0,
+                        [](int s, Package *p2) { return s + p2->count; });
+    mg::info("Goods for sale:", gc);
+  }
+
+  order = market->cities;
+  std::shuffle(order.begin(), order.end(), gen);
+  unsigned int sn = 0;
+  for (auto c : order) {
+    sn += buyGoods(c);
+  }
+  if (verbose) {
+    mg::info("Still needs:", sn);
+  }
+
+  auto w = kernels::reduce(wealth.data(), wealth.size(), 0.f);
+  report.wealth.push_back(w.sum);
+  report.maxWealth = std::max(report.maxWealth, w.max);
+  report.minWealth = std::min(report.minWealth, w.min);
+}
+
+void EconomyRun::populationTick() {
+  kernels::growPopulation(population.data(), wealth.data(), population.size(),
+                          vars.POPULATION_GROWS,
+                          vars.POPULATION_GROWS_WEALTH_MODIFIER);
+  auto p = kernels::reduce(population.data(), population.size(),
+                           Economy::INITIAL_POPULATION);
+  report.population.push_back(p.sum);
+  report.maxPopulation = std::max(report.maxPopulation, p.max);
+  report.minPopulation = std::min(report.minPopulation, p.min);
+}
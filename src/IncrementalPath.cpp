@@ -0,0 +1,173 @@
+#include "mapgen/IncrementalPath.hpp"
+#include "mapgen/utils.hpp"
+#include <limits>
+
+const float INF = std::numeric_limits<float>::max();
+
+// Incoming edges are packed once per map, pointing into the map's own edge
+// array so cost changes from roads are seen without copying.
+IncrementalPath::IncrementalPath(Map *m)
+    : map(m), scale(m->getMinCostRatio() * ROAD_COST) {
+  int size = map->regions.size();
+  stamp.assign(size, 0);
+  onPath.assign(size, 0);
+  g.resize(size);
+  rhs.resize(size);
+  keys.resize(size);
+  queued.resize(size);
+  inOffsets.assign(size + 1, 0);
+  for (auto r : map->regions) {
+    for (auto e = map->edgesBegin(r); e != map->edgesEnd(r); e++) {
+      inOffsets[((Region *)e->state)->id + 1]++;
+    }
+  }
+  for (int i = 0; i < size; i++) {
+    inOffsets[i + 1] += inOffsets[i];
+  }
+  inEdges.resize(inOffsets[size]);
+  std::vector<int> fill(inOffsets.begin(), inOffsets.end() - 1);
+  for (auto r : map->regions) {
+    for (auto e = map->edgesBegin(r); e != map->edgesEnd(r); e++) {
+      inEdges[fill[((Region *)e->state)->id]++] = {r->id, e};
+    }
+  }
+}
+
+void IncrementalPath::touch(int s) {
+  if (stamp[s] != generation) {
+    stamp[s] = generation;
+    g[s] = INF;
+    rhs[s] = INF;
+    queued[s] = false;
+  }
+}
+
+void IncrementalPath::reset(Region *s) {
+  generation++;
+  source = s->id;
+  target = -1;
+  km = 0.f;
+  queue.clear();
+  touch(source);
+  rhs[source] = 0.f;
+}
+
+float IncrementalPath::heuristic(int a, int b) {
+  return mg::getDistance(map->regions[a]->site, map->regions[b]->site) *
+         scale;
+}
+
+IncrementalPath::Key IncrementalPath::calculateKey(int s) {
+  float m = std::min(g[s], rhs[s]);
+  if (m == INF) {
+    return Key(INF, INF);
+  }
+  return Key(m + heuristic(s, target) + km, m);
+}
+
+void IncrementalPath::updateVertex(int u) {
+  touch(u);
+  if (u != source) {
+    float best = INF;
+    for (int i = inOffsets[u]; i < inOffsets[u + 1]; i++) {
+      int p = inEdges[i].from;
+      if (stamp[p] != generation || g[p] == INF) {
+        continue;
+      }
+      best = std::min(best, g[p] + inEdges[i].edge->cost);
+    }
+    rhs[u] = best;
+  }
+  if (queued[u]) {
+    queue.erase(std::make_pair(keys[u], u));
+    queued[u] = false;
+  }
+  if (g[u] != rhs[u]) {
+    keys[u] = calculateKey(u);
+    queue.insert(std::make_pair(keys[u], u));
+    queued[u] = true;
+  }
+}
+
+void IncrementalPath::computePath() {
+  while (!queue.empty() &&
+         (queue.begin()->first < calculateKey(target) ||
+          rhs[target] != g[target])) {
+    Key old = queue.begin()->first;
+    int u = queue.begin()->second;
+    Key fresh = calculateKey(u);
+    if (old < fresh) {
+      queue.erase(queue.begin());
+      keys[u] = fresh;
+      queue.insert(std::make_pair(fresh, u));
+      continue;
+    }
+    queue.erase(queue.begin());
+    queued[u] = false;
+    expanded++;
+    Region *r = map->regions[u];
+    if (g[u] > rhs[u]) {
+      g[u] = rhs[u];
+    } else {
+      g[u] = INF;
+      updateVertex(u);
+    }
+    for (auto e = map->edgesBegin(r); e != map->edgesEnd(r); e++) {
+      updateVertex(((Region *)e->state)->id);
+    }
+  }
+}
+
+void IncrementalPath::updateRegion(Region *r) { updateVertex(r->id); }
+
+bool IncrementalPath::getPath(Region *t, micropather::MPVector<void *> *path,
+                              float *cost) {
+  path->clear();
+  touch(t->id);
+  if (target == -1) {
+    target = t->id;
+    keys[source] = calculateKey(source);
+    queue.insert(std::make_pair(keys[source], source));
+    queued[source] = true;
+  } else if (target != t->id) {
+    km += heuristic(target, t->id);
+    target = t->id;
+  }
+  computePath();
+  if (g[target] == INF) {
+    return false;
+  }
+  *cost = g[target];
+
+  // Walk back over the cheapest predecessors; zero-cost edges can tie, so
+  // regions already on the path are skipped.
+  walk++;
+  std::vector<int> nodes(1, target);
+  onPath[target] = walk;
+  int s = target;
+  while (s != source) {
+    int next = -1;
+    float best = INF;
+    for (int i = inOffsets[s]; i < inOffsets[s + 1]; i++) {
+      int p = inEdges[i].from;
+      if (stamp[p] != generation || g[p] == INF || onPath[p] == walk) {
+        continue;
+      }
+      float c = g[p] + inEdges[i].edge->cost;
+      if (c < best) {
+        best = c;
+        next = p;
+      }
+    }
+    if (next == -1) {
+      return false;
+    }
+    onPath[next] = walk;
+    nodes.push_back(next);
+    s = next;
+  }
+  for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    path->push_back(map->regions[*it]);
+  }
+  return true;
+}
@@ -0,0 +1,117 @@
+#include "mapgen/Isochrone.hpp"
+#include <atomic>
+#include <limits>
+#include <queue>
+#include <thread>
+
+Isochrone::Isochrone(Map *m) : map(m) {
+  int n = map->regions.size();
+  stamp.assign(n, 0);
+  closed.assign(n, false);
+  cost.assign(n, 0.f);
+  source.assign(n, -1);
+}
+
+void Isochrone::touch(int id) {
+  if (stamp[id] != generation) {
+    stamp[id] = generation;
+    closed[id] = false;
+    cost[id] = std::numeric_limits<float>::max();
+    source[id] = -1;
+  }
+}
+
+// Multi-source Dijkstra that settles nothing costlier than maxCost. Ties
+// go to the earlier source, so catchments do not depend on queue order.
+// With goals > 0 it stops once that many isGoal regions are settled.
+void Isochrone::expand(const std::vector<Region *> &sources, float maxCost,
+                       MegaCluster *within, int goals,
+                       const std::function<bool(Region *)> &isGoal) {
+  generation++;
+  regions.clear();
+  found.clear();
+
+  typedef std::pair<std::pair<float, int>, Region *> Item;
+  auto later = [](const Item &a, const Item &b) { return a.first > b.first; };
+  std::priority_queue<Item, std::vector<Item>, decltype(later)> queue(later);
+  for (size_t i = 0; i < sources.size(); i++) {
+    Region *s = sources[i];
+    touch(s->id);
+    if (source[s->id] == -1) {
+      cost[s->id] = 0.f;
+      source[s->id] = i;
+      queue.push(std::make_pair(std::make_pair(0.f, int(i)), s));
+    }
+  }
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    Region *u = top.second;
+    if (closed[u->id]) {
+      continue;
+    }
+    closed[u->id] = true;
+    regions.push_back(u);
+    if (isGoal && isGoal(u)) {
+      found.push_back(u);
+      if (goals > 0 && int(found.size()) >= goals) {
+        return;
+      }
+    }
+
+    adjacent.clear();
+    map->AdjacentCost(u, &adjacent);
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      Region *v = (Region *)adjacent[i].state;
+      if (within != nullptr && v->megaCluster != within) {
+        continue;
+      }
+      touch(v->id);
+      float c = cost[u->id] + adjacent[i].cost;
+      if (closed[v->id] || c > maxCost) {
+        continue;
+      }
+      if (c < cost[v->id] ||
+          (c == cost[v->id] && source[u->id] < source[v->id])) {
+        cost[v->id] = c;
+        source[v->id] = source[u->id];
+        queue.push(std::make_pair(std::make_pair(c, source[v->id]), v));
+      }
+    }
+  }
+}
+
+bool Isochrone::reached(Region *r) {
+  return stamp[r->id] == generation && closed[r->id];
+}
+
+float Isochrone::getCost(Region *r) { return cost[r->id]; }
+
+int Isochrone::getSource(Region *r) { return source[r->id]; }
+
+std::vector<std::vector<Region *>>
+Isochrone::nearestEach(Map *map, const std::vector<Region *> &sources,
+                       int goals, const std::function<bool(Region *)> &isGoal) {
+  const int sc = sources.size();
+  std::vector<std::vector<Region *>> result(sc);
+  int n = std::max(1, std::min(int(std::thread::hardware_concurrency()), sc));
+  std::atomic<int> next(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < n; t++) {
+    workers.push_back(std::thread([&]() {
+      Isochrone isochrone(map);
+      int i;
+      while ((i = next++) < sc) {
+        Region *s = sources[i];
+        isochrone.expand({s}, std::numeric_limits<float>::max(),
+                         s->megaCluster, goals,
+                         [&](Region *r) { return r != s && isGoal(r); });
+        result[i] = isochrone.found;
+      }
+    }));
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  return result;
+}
@@ -0,0 +1,105 @@
+#include "mapgen/Landmarks.hpp"
+#include "mapgen/Map.hpp"
+#include "mapgen/utils.hpp"
+#include <limits>
+#include <queue>
+
+const float UNREACHED = std::numeric_limits<float>::max();
+
+Landmarks::Landmarks(Map *map, int k) : size(map->regions.size()) {
+  Graph forward(size);
+  Graph backward(size);
+  MP_VECTOR<micropather::StateCost> adjacent;
+  for (auto r : map->regions) {
+    adjacent.clear();
+    map->AdjacentCost(r, &adjacent);
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      int n = ((Region *)adjacent[i].state)->id;
+      forward[r->id].push_back(std::make_pair(n, adjacent[i].cost));
+      backward[n].push_back(std::make_pair(r->id, adjacent[i].cost));
+    }
+  }
+
+  // Farthest-point selection; regions no landmark reaches come first so
+  // every component gets one.
+  std::vector<float> nearest(size, UNREACHED);
+  std::vector<std::vector<float>> fromRows;
+  std::vector<std::vector<float>> toRows;
+  int next = -1;
+  for (int v = 0; v < size && next == -1; v++) {
+    if (!forward[v].empty()) {
+      next = v;
+    }
+  }
+  while ((int)regions.size() < k && next != -1) {
+    regions.push_back(map->regions[next]);
+    fromRows.emplace_back();
+    toRows.emplace_back();
+    dijkstra(next, forward, fromRows.back());
+    dijkstra(next, backward, toRows.back());
+
+    next = -1;
+    for (int v = 0; v < size; v++) {
+      nearest[v] = std::min(nearest[v], fromRows.back()[v]);
+      if (nearest[v] == 0.f || forward[v].empty()) {
+        continue;
+      }
+      if (next == -1 || nearest[v] > nearest[next]) {
+        next = v;
+      }
+    }
+  }
+
+  count = regions.size();
+  from.assign(size * count, UNREACHED);
+  to.assign(size * count, UNREACHED);
+  for (int i = 0; i < count; i++) {
+    for (int v = 0; v < size; v++) {
+      from[v * count + i] = fromRows[i][v];
+      to[v * count + i] = toRows[i][v];
+    }
+  }
+  mg::info("Landmarks:", count);
+}
+
+void Landmarks::dijkstra(int s, Graph &graph, std::vector<float> &dist) {
+  dist.assign(size, UNREACHED);
+  typedef std::pair<float, int> Item;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+  dist[s] = 0.f;
+  queue.push(std::make_pair(0.f, s));
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    int u = top.second;
+    if (top.first > dist[u]) {
+      continue;
+    }
+    for (auto &e : graph[u]) {
+      float c = dist[u] + e.second;
+      if (c < dist[e.first]) {
+        dist[e.first] = c;
+        queue.push(std::make_pair(c, e.first));
+      }
+    }
+  }
+}
+
+// max over landmarks L of d(L,b) - d(L,a) and d(a,L) - d(b,L); terms with an
+// unreached side carry no bound and are skipped.
+float Landmarks::estimate(Region *a, Region *b) {
+  const float *fa = &from[a->id * count];
+  const float *fb = &from[b->id * count];
+  const float *ta = &to[a->id * count];
+  const float *tb = &to[b->id * count];
+  float h = 0.f;
+  for (int i = 0; i < count; i++) {
+    if (fa[i] != UNREACHED && fb[i] != UNREACHED) {
+      h = std::max(h, fb[i] - fa[i]);
+    }
+    if (ta[i] != UNREACHED && tb[i] != UNREACHED) {
+      h = std::max(h, ta[i] - tb[i]);
+    }
+  }
+  return h;
+}
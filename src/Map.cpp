@@ -1,6 +1,14 @@
 #include "mapgen/Map.hpp"
+#include "mapgen/Landmarks.hpp"
+#include "mapgen/SeaLanes.hpp"
+#include "mapgen/utils.hpp"
+#include <algorithm>
+#include <limits>
 
-Map::~Map(){};
+Map::~Map() {
+  delete landmarks;
+  delete seaLanes;
+};
 
 float Map::getRegionDistance(Region *r, Region *r2) {
   Point p = r->site;
@@ -12,10 +20,13 @@ float Map::getRegionDistance(Region *r, Region *r2) {
   if (r->megaCluster->isLand) {
     float hd = (r->getHeight(r->site) - r2->getHeight(r2->site));
     if (hd < 0) {
-      d += 1000 * std::abs(hd);
-      if (r2->city != nullptr && d >= 500) {
-        d -= 500;
+      // Climbing into a city is discounted, but only the climb itself, so
+      // no edge costs less than its flat distance.
+      float climb = 1000 * std::abs(hd);
+      if (r2->city != nullptr) {
+        climb = std::max(0.f, climb - 500);
       }
+      d += climb;
     }
     if (r2->hasRiver) {
       d *= 0.6;
@@ -24,7 +35,7 @@ float Map::getRegionDistance(Region *r, Region *r2) {
       d *= 1.2;
     }
     if (r2->hasRoad) {
-      d *= 0.2;
+      d *= ROAD_COST;
     }
   } else {
     d *= 0.8;
@@ -32,36 +43,201 @@ float Map::getRegionDistance(Region *r, Region *r2) {
   return d;
 }
 
+// Euclidean distance scaled by the smallest cost/length ratio of any packed
+// edge, tightened by the landmark bound while landmarks are valid. Both
+// are lower bounds, so the estimate is admissible and consistent.
 float Map::LeastCostEstimate(void *stateStart, void *stateEnd) {
-  return getRegionDistance((Region *)stateStart, (Region *)stateEnd);
+  auto r = (Region *)stateStart;
+  auto r2 = (Region *)stateEnd;
+  float h = mg::getDistance(r->site, r2->site) * minCostRatio;
+  if (landmarks != nullptr) {
+    h = std::max(h, landmarks->estimate(r, r2));
+  }
+  return h;
 };
 
-void Map::AdjacentCost(void *state,
-                       MP_VECTOR<micropather::StateCost> *neighbors) {
-  auto r = ((Region *)state);
-  for (auto n : r->neighbors) {
+bool Map::isPassable(Region *r, Region *n) {
+  if (n->biom.name == "Lake") {
+    return false;
+  }
+  if (r->megaCluster->isLand) {
+    if (!n->megaCluster->isLand) {
+      if (r->city == nullptr || r->city->type != PORT) {
+        return false;
+      }
+    }
+  } else {
+    if (n->megaCluster->isLand) {
+      if (n->city == nullptr || n->city->type != PORT) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
 
-    if (n->biom.name == "Lake") {
-      continue;
+// Prices an edge and keeps minCostRatio at or below its cost/length ratio.
+float Map::getEdgeCost(Region *r, Region *n) {
+  float c = getRegionDistance(r, n);
+  float d = mg::getDistance(r->site, n->site);
+  if (d > 0) {
+    minCostRatio = std::min(minCostRatio, c / d);
+  }
+  return c;
+}
+
+// Packs every region's passable neighbors and their costs (CSR, indexed by
+// region id). Call when cities or ports change; roads only need the
+// cheaper updateEdges(Road*). Landmarks cost two full Dijkstras each, so
+// they are only built for stages whose searches use LeastCostEstimate.
+void Map::updateEdges(bool withLandmarks) {
+  minCostRatio = std::numeric_limits<float>::max();
+  edgeOffsets.assign(regions.size() + 1, 0);
+  edges.clear();
+  for (auto r : regions) {
+    for (auto n : r->neighbors) {
+      if (isPassable(r, n)) {
+        edges.push_back({(void *)n, getEdgeCost(r, n)});
+      }
     }
-    if (r->megaCluster->isLand) {
-      if (!n->megaCluster->isLand) {
-        if (r->city == nullptr || r->city->type != PORT) {
-          continue;
+    edgeOffsets[r->id + 1] = edges.size();
+  }
+  if (edges.empty()) {
+    minCostRatio = 0.f;
+  }
+  mg::info("Min cost ratio:", std::to_string(minCostRatio));
+
+  delete seaLanes;
+  seaLanes = nullptr;
+  if (useSeaLanes) {
+    seaLanes = new SeaLanes(this);
+    packSeaLanes();
+  }
+
+  delete landmarks;
+  landmarks = nullptr;
+  if (withLandmarks && landmarkCount > 0) {
+    landmarks = new Landmarks(this, landmarkCount);
+  }
+}
+
+// Roads only make edges cheaper, which would let landmark distances
+// overestimate, so landmarks are dropped until the next full update.
+void Map::updateEdges(Road *road) {
+  if (edgeOffsets.empty()) {
+    return;
+  }
+  delete landmarks;
+  landmarks = nullptr;
+  for (auto r : road->regions) {
+    for (auto n : r->neighbors) {
+      for (int i = edgeOffsets[n->id]; i < edgeOffsets[n->id + 1]; i++) {
+        if (edges[i].state == (void *)r &&
+            (seaLanes == nullptr || !seaLanes->hasLane(n, r))) {
+          edges[i].cost = getEdgeCost(n, r);
         }
       }
-    } else {
-      if (n->megaCluster->isLand) {
-        if (n->city == nullptr || n->city->type != PORT) {
-          continue;
+    }
+  }
+}
+
+// Keeps only land edges and adds the sea lanes of each port, so water
+// regions drop out of the graph. Lane costs are refreshed by the next full
+// update, not by roads.
+void Map::packSeaLanes() {
+  std::vector<int> offsets(regions.size() + 1, 0);
+  std::vector<micropather::StateCost> packed;
+  for (auto r : regions) {
+    if (r->megaCluster->isLand) {
+      auto &lanes = seaLanes->getOutgoing(r);
+      for (int i = edgeOffsets[r->id]; i < edgeOffsets[r->id + 1]; i++) {
+        auto n = (Region *)edges[i].state;
+        if (n->megaCluster->isLand && !seaLanes->hasLane(r, n)) {
+          packed.push_back(edges[i]);
         }
       }
+      for (auto &lane : lanes) {
+        packed.push_back({(void *)lane.port, lane.cost});
+      }
     }
+    offsets[r->id + 1] = packed.size();
+  }
+  edgeOffsets.swap(offsets);
+  edges.swap(packed);
+}
+
+// Puts the water regions of every sea lane back between its two ports.
+void Map::expandSeaLanes(micropather::MPVector<void *> *path) {
+  if (seaLanes == nullptr) {
+    return;
+  }
+  std::vector<void *> expanded;
+  for (unsigned int i = 0; i < path->size(); i++) {
+    if (i > 0) {
+      seaLanes->expand((Region *)(*path)[i - 1], (Region *)(*path)[i],
+                       expanded);
+    }
+    expanded.push_back((*path)[i]);
+  }
+  path->clear();
+  for (auto r : expanded) {
+    path->push_back(r);
+  }
+}
+
+float Map::getMinCostRatio() { return minCostRatio; }
 
-    micropather::StateCost nodeCost = {
-        (void *)n, getRegionDistance((Region *)state, (Region *)n)};
+void Map::AdjacentCost(void *state,
+                       MP_VECTOR<micropather::StateCost> *neighbors) {
+  auto r = ((Region *)state);
+  if (!edgeOffsets.empty()) {
+    for (int i = edgeOffsets[r->id]; i < edgeOffsets[r->id + 1]; i++) {
+      neighbors->push_back(edges[i]);
+    }
+    return;
+  }
+  for (auto n : r->neighbors) {
+    if (!isPassable(r, n)) {
+      continue;
+    }
+    micropather::StateCost nodeCost = {(void *)n, getRegionDistance(r, n)};
     neighbors->push_back(nodeCost);
   }
 };
-void Map::PrintStateInfo(void *state){};
+// Edges into state, with their costs, for searches that run backwards.
+void Map::IncomingCost(void *state,
+                       MP_VECTOR<micropather::StateCost> *incoming) {
+  auto r = ((Region *)state);
+  for (auto n : r->neighbors) {
+    if (edgeOffsets.empty()) {
+      if (isPassable(n, r)) {
+        incoming->push_back({(void *)n, getRegionDistance(n, r)});
+      }
+      continue;
+    }
+    for (int i = edgeOffsets[n->id]; i < edgeOffsets[n->id + 1]; i++) {
+      if (edges[i].state == state) {
+        incoming->push_back({(void *)n, edges[i].cost});
+      }
+    }
+  }
+  if (seaLanes == nullptr || edgeOffsets.empty()) {
+    return;
+  }
+  for (auto &lane : seaLanes->getIncoming(r)) {
+    if (std::find(r->neighbors.begin(), r->neighbors.end(), lane.port) ==
+        r->neighbors.end()) {
+      incoming->push_back({(void *)lane.port, lane.cost});
+    }
+  }
+}
+
+const micropather::StateCost *Map::edgesBegin(Region *r) {
+  return edgeOffsets.empty() ? nullptr : edges.data() + edgeOffsets[r->id];
+}
+
+const micropather::StateCost *Map::edgesEnd(Region *r) {
+  return edgeOffsets.empty() ? nullptr : edges.data() + edgeOffsets[r->id + 1];
+}
 
+void Map::PrintStateInfo(void *state){};
@@ -1,28 +1,58 @@
 #include "mapgen/MapGenerator.hpp"
 #include "mapgen/Biom.hpp"
 #include "mapgen/Map.hpp"
+#include "mapgen/SpatialHash.hpp"
 #include "mapgen/names.hpp"
 #include "mapgen/utils.hpp"
 #include "rang.hpp"
 #include <VoronoiDiagramGenerator.h>
+#include <cmath>
+#include <deque>
 #include <iterator>
+#include <queue>
 #include <random>
 
-template <typename T> using filterFunc = std::function<bool(T *)>;
-template <typename T> using sortFunc = std::function<bool(T *, T *)>;
-
-template <typename T>
-std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
-                               sortFunc<T> sort) {
-  std::vector<T *> places;
-
-  std::copy_if(regions.begin(), regions.end(), std::back_inserter(places),
-               filter);
-  std::sort(places.begin(), places.end(), sort);
-  return places;
-}
-
 const int DEFAULT_RELAX = 5;
+const float PORT_SEA_REACH = 100.f;
+const int PORT_SEA_AREA = 200;
+const float MINE_SPACING = 20.f;
+const float PORT_SPACING = 200.f;
+const float STATE_SEA_COST = 3.f;
+const float STATE_HEIGHT_COST = 10.f;
+
+const std::vector<sf::Color> STATE_COLORS = {
+    sf::Color(0, 107, 218),  sf::Color(170, 62, 62),  sf::Color(62, 150, 62),
+    sf::Color(190, 150, 40), sf::Color(130, 70, 170), sf::Color(40, 160, 160),
+    sf::Color(200, 100, 30), sf::Color(90, 90, 90)};
+
+// The fixed palette while it lasts, otherwise `count` evenly spaced hues so
+// no two states share a color.
+sf::Color stateColor(int n, int count) {
+  if (count <= int(STATE_COLORS.size())) {
+    return STATE_COLORS[n];
+  }
+  float h = 6.f * n / count;
+  int sector = int(h) % 6;
+  float f = h - std::floor(h);
+  const int v = 200;
+  const int low = 60;
+  int rise = low + int((v - low) * f);
+  int fall = v - int((v - low) * f);
+  switch (sector) {
+  case 0:
+    return sf::Color(v, rise, low);
+  case 1:
+    return sf::Color(fall, v, low);
+  case 2:
+    return sf::Color(low, v, rise);
+  case 3:
+    return sf::Color(low, fall, v);
+  case 4:
+    return sf::Color(rise, low, v);
+  default:
+    return sf::Color(v, low, fall);
+  }
+}
 
 bool cellsOrdered(Cell *c1, Cell *c2) {
   sf::Vector2<double> s1 = c1->site.p;
@@ -59,10 +89,12 @@ Iter MapGenerator::select_randomly(Iter start, Iter end) {
 MapGenerator::MapGenerator(int w, int h) : _w(w), _h(h) {
   _vdg = VoronoiDiagramGenerator();
   _pointsCount = 10000;
+  _statesCount = 2;
   _octaves = 4;
   _freq = 0.3;
   _relax = DEFAULT_RELAX;
   simpleRivers = true;
+  climate = true;
   _terrainType = "basic";
   temperature = biom::DEFAULT_TEMPERATURE;
   map = nullptr;
@@ -70,50 +102,111 @@ MapGenerator::MapGenerator(int w, int h) : _w(w), _h(h) {
   _gen = new std::mt19937(_seed);
 }
 
-void MapGenerator::makeStates() {
-  map->status = "Making states...";
-  map->stateClusters.clear();
+void MapGenerator::makeStateSeeds() {
+  auto land = mg::filterObjects(map->regions, [&](Region *r) {
+    return r->megaCluster->isLand && r->biom.name != biom::LAKE.name;
+  });
+  if (land.size() == 0) {
+    return;
+  }
 
-  _bbox = sf::Rect<double>(0, 0, _w, _h);
-  VoronoiDiagramGenerator vdg;
-  auto sites = new std::vector<sf::Vector2<double>>();
-  genRandomSites(*sites, _bbox, _w, _h, 2);
-  std::unique_ptr<Diagram> diagram;
-  diagram.reset(vdg.compute(*sites, _bbox));
-
-  int n = 0;
-  for (auto c : diagram->cells) {
-    State *s = new State(
-        (n == 0 ? "Blue empire" : "Red lands"),
-        (n == 0 ? sf::Color(0, 107, 218) : sf::Color(170, 62, 62)), c);
+  float spacing = std::sqrt(float(_w) * _h / _statesCount) / 2.f;
+  SpatialHash seeds(spacing);
+  int tries = 0;
+  int count = std::min(_statesCount, int(land.size()));
+  while (int(map->states.size()) < count) {
+    Region *r = *select_randomly(land.begin(), land.end());
+    if (++tries >= 100 * _statesCount) {
+      // Too crowded for this spacing: shrink it instead of reusing a seed.
+      spacing /= 2.f;
+      tries = 0;
+    }
+    if (seeds.hasNear(r->site, spacing)) {
+      continue;
+    }
+    seeds.insert(r);
+    int n = map->states.size();
+    State *s = new State(n, names::generateLandName(_gen),
+                         stateColor(n, count), r);
     map->states.push_back(s);
-    n++;
+  }
+}
+
+// Weighted multi-source flood (Dijkstra) from every state center at once.
+// Sea and climbing are more expensive to cross, so borders follow coasts
+// and ridges, and the cost does not depend on the number of states.
+void MapGenerator::floodStates() {
+  typedef std::pair<float, Region *> Front;
+  std::vector<float> cost(map->regions.size(),
+                          std::numeric_limits<float>::max());
+  std::vector<State *> owner(map->regions.size(), nullptr);
+  std::priority_queue<Front, std::vector<Front>, std::greater<Front>> queue;
+
+  for (auto s : map->states) {
+    cost[s->center->id] = 0.f;
+    owner[s->center->id] = s;
+    queue.push(std::make_pair(0.f, s->center));
   }
 
-  for (auto r : map->regions) {
-    if (!r->megaCluster->isLand) {
+  while (!queue.empty()) {
+    auto front = queue.top();
+    queue.pop();
+    Region *r = front.second;
+    if (front.first > cost[r->id]) {
       continue;
     }
-    for (auto s : map->states) {
-      if (s->cell->pointIntersection(r->site->x, r->site->y) != -1) {
-        r->state = s;
-        auto ms = r->megaCluster->states;
-        if (std::count(ms.begin(), ms.end(), s) == 0) {
-          r->megaCluster->states.push_back(s);
-        }
-        auto cs = r->cluster->states;
-        if (std::count(cs.begin(), cs.end(), s) == 0) {
-          r->cluster->states.push_back(s);
-        }
-        break;
+    for (auto n : r->neighbors) {
+      float d = mg::getDistance(r->site, n->site);
+      if (!r->megaCluster->isLand || !n->megaCluster->isLand) {
+        d *= STATE_SEA_COST;
+      } else {
+        float hd = n->getHeight(n->site) - r->getHeight(r->site);
+        d *= 1.f + STATE_HEIGHT_COST * std::abs(hd);
+      }
+      float nc = front.first + d;
+      if (nc < cost[n->id]) {
+        cost[n->id] = nc;
+        owner[n->id] = owner[r->id];
+        queue.push(std::make_pair(nc, n));
       }
     }
   }
 
-  auto regions = filterObjects(
-      map->regions,
-      (filterFunc<Region>)[&](Region * r) { return r->megaCluster->isLand; },
-      (sortFunc<Region>)[&](Region * r, Region * r2) { return false; });
+  for (auto r : map->regions) {
+    if (r->megaCluster->isLand) {
+      r->state = owner[r->id];
+    }
+  }
+
+  std::vector<Cluster *> stamps(map->states.size(), nullptr);
+  auto collect = [&](Cluster *c) {
+    for (auto r : c->regions) {
+      if (r->state != nullptr && stamps[r->state->id] != c) {
+        stamps[r->state->id] = c;
+        c->states.push_back(r->state);
+      }
+    }
+  };
+  for (auto mc : map->megaClusters) {
+    if (mc->isLand) {
+      collect(mc);
+    }
+  }
+  std::fill(stamps.begin(), stamps.end(), nullptr);
+  for (auto c : map->clusters) {
+    collect(c);
+  }
+}
+
+void MapGenerator::makeStates() {
+  map->status = "Making states...";
+  map->stateClusters.clear();
+
+  makeStateSeeds();
+  floodStates();
+
+  auto regions = mg::filterObjects(
+      map->regions, [&](Region *r) { return r->megaCluster->isLand; });
 
   auto sc = clusterize(
       regions, [&](Region *r, Region *rn) { return r->state != rn->state; },
@@ -311,6 +404,10 @@ void MapGenerator::setFrequency(float f) { _freq = f; }
 
 void MapGenerator::setPointCount(int c) { _pointsCount = c; }
 
+int MapGenerator::getStatesCount() { return _statesCount; }
+
+void MapGenerator::setStatesCount(int c) { _statesCount = c; }
+
 void MapGenerator::update() {
   ready = false;
   if (map != nullptr) {
@@ -325,12 +422,16 @@ void MapGenerator::update() {
 
   makeRegions();
   makeMegaClusters();
+  makeCoasts();
 
   makeRivers();
   if (simpleRivers) {
     simplifyRivers();
   }
   calcHumidity();
+  if (climate) {
+    makeClimate();
+  }
   calcTemp();
 
   makeMinerals();
@@ -351,108 +452,142 @@ void MapGenerator::startSimulation() {
   ready = true;
 }
 
-void MapGenerator::getSea(std::vector<Region *> *seas, Region *base,
-                          Region *r) {
-  for (auto n : r->neighbors) {
-    if (!n->megaCluster->isLand &&
-        std::find(seas->begin(), seas->end(), n) == seas->end()) {
-      seas->push_back(n);
-      float d = mg::getDistance(base->site, n->site);
-      if (d < 100) {
-        getSea(seas, base, n);
+void MapGenerator::startBatch(std::vector<EconomyVars> runs) {
+  map->status = "";
+  ready = false;
+  simulator->simulateBatch(runs);
+  ready = true;
+}
+
+void MapGenerator::continueSimulation(int years) {
+  map->status = "";
+  ready = false;
+  simulator->continueEconomy(years);
+  ready = true;
+}
+
+void MapGenerator::restoreSnapshot(int i) {
+  map->status = "";
+  ready = false;
+  simulator->restoreSnapshot(i);
+  ready = true;
+}
+
+// Multi-source BFS from the shoreline: coastDistance is the number of hops
+// to the nearest region of the other kind (land or sea), seaArea is the size
+// of the water body a sea region belongs to (or the largest one touching a
+// coastal land region). Every sea region also remembers the shore it was
+// reached from, and seaReach of a coastal land region is the distance to
+// the farthest such water: small in bays, large on open coasts.
+void MapGenerator::makeCoasts() {
+  map->status = "Measuring coasts...";
+  std::deque<Region *> queue;
+  std::vector<bool> visited(map->regions.size(), false);
+  std::vector<Region *> shore(map->regions.size(), nullptr);
+
+  for (auto r : map->regions) {
+    r->coastDistance = 0;
+    r->seaReach = 0.f;
+    r->seaArea = r->megaCluster->isLand ? 0 : r->megaCluster->regions.size();
+    bool coast = false;
+    for (auto n : r->neighbors) {
+      if (n->megaCluster->isLand != r->megaCluster->isLand) {
+        coast = true;
+        if (shore[r->id] == nullptr && n->megaCluster->isLand) {
+          shore[r->id] = n;
+        }
+        if (!n->megaCluster->isLand) {
+          r->seaArea = std::max(r->seaArea, int(n->megaCluster->regions.size()));
+        }
+      }
+    }
+    if (coast) {
+      visited[r->id] = true;
+      queue.push_back(r);
+    }
+  }
+
+  while (!queue.empty()) {
+    Region *r = queue.front();
+    queue.pop_front();
+    for (auto n : r->neighbors) {
+      if (visited[n->id] || n->megaCluster->isLand != r->megaCluster->isLand) {
+        continue;
       }
+      visited[n->id] = true;
+      n->coastDistance = r->coastDistance + 1;
+      shore[n->id] = shore[r->id];
+      queue.push_back(n);
     }
   }
-};
+
+  for (auto r : map->regions) {
+    Region *s = shore[r->id];
+    if (s != nullptr) {
+      s->seaReach =
+          std::max(s->seaReach, float(mg::getDistance(s->site, r->site)));
+    }
+  }
+}
 
 void MapGenerator::makeCities() {
   map->status = "Founding cities...";
 
   std::vector<Region *> places;
 
-  std::vector<Region *> cache;
+  SpatialHash mines(MINE_SPACING);
   for (auto mc : map->megaClusters) {
     if (!mc->isLand) {
       continue;
     }
-    places = filterObjects(mc->regions,
-                           (filterFunc<Region>)[&](Region * r) {
-                             bool cond = r->city == nullptr &&
-                                         r->minerals > 1 &&
-                                         r->biom.name != biom::LAKE.name &&
-                                         r->biom.name != biom::SNOW.name &&
-                                         r->biom.name != biom::ICE.name;
-                             // if (cond && std::none_of(cache.begin(),
-                             // cache.end(), [&](Region *ri){
-                             //       for (auto rn : cache) {
-                             //         if (mg::getDistance(ri->site, rn->site)
-                             //         < 20) {
-                             //           return true;
-                             //         }
-                             //       }
-                             //       return false;
-                             //     })) {
-                             //   cache.push_back(r);
-                             // } else {
-                             //   return false;
-                             // }
-                             return cond;
-                           },
-                           (sortFunc<Region>)[&](Region * r, Region * r2) {
-                             if (r->minerals > r2->minerals) {
-                               return true;
-                             }
-                             return false;
-                           });
-    for (auto r : places) {
-      bool canPlace = true;
-      for (auto n : r->neighbors) {
-        if (n->city != nullptr) {
-          canPlace = false;
-          break;
-        }
-      }
-      if (!canPlace) {
-        continue;
-      }
-      // TODO: decluster it.
-      City *c = new City(r, names::generateCityName(_gen), MINE);
-      map->cities.push_back(c);
-      mc->cities.push_back(c);
-    }
+    mg::visitTopObjects(
+        mc->regions,
+        [&](Region *r) {
+          return r->city == nullptr && r->minerals > 1 &&
+                 r->biom.name != biom::LAKE.name &&
+                 r->biom.name != biom::SNOW.name &&
+                 r->biom.name != biom::ICE.name;
+        },
+        [](Region *r) { return r->minerals; },
+        [&](Region *r) {
+          if (mines.hasNear(r->site, MINE_SPACING)) {
+            return true;
+          }
+          for (auto n : r->neighbors) {
+            if (n->city != nullptr) {
+              return true;
+            }
+          }
+          City *c = new City(r, names::generateCityName(_gen), MINE);
+          map->cities.push_back(c);
+          mc->cities.push_back(c);
+          mines.insert(r);
+          return true;
+        });
   }
 
   for (auto mc : map->megaClusters) {
     if (!mc->isLand) {
       continue;
     }
-    places = filterObjects(
+    mg::visitTopObjects(
         mc->regions,
-        (filterFunc<Region>)[&](Region * r) {
+        [&](Region *r) {
           return r->city == nullptr && r->nice > 0.8 &&
                  r->biom.feritlity > 0.7 && r->biom.name != biom::LAKE.name;
         },
-        (sortFunc<Region>)[&](Region * r, Region * r2) {
-          if (r->nice * r->biom.feritlity > r2->nice * r2->biom.feritlity) {
-            return true;
+        [](Region *r) { return r->nice * r->biom.feritlity; },
+        [&](Region *r) {
+          for (auto n : r->neighbors) {
+            if (n->city != nullptr) {
+              return true;
+            }
           }
-          return false;
+          City *c = new City(r, names::generateCityName(_gen), AGRO);
+          map->cities.push_back(c);
+          mc->cities.push_back(c);
+          return true;
         });
-    for (auto r : places) {
-      bool canPlace = true;
-      for (auto n : r->neighbors) {
-        if (n->city != nullptr) {
-          canPlace = false;
-          break;
-        }
-      }
-      if (!canPlace) {
-        continue;
-      }
-      City *c = new City(r, names::generateCityName(_gen), AGRO);
-      map->cities.push_back(c);
-      mc->cities.push_back(c);
-    }
   }
 
   for (auto mc : map->megaClusters) {
@@ -460,12 +595,10 @@ void MapGenerator::makeCities() {
       continue;
     }
 
-    int b = 200;
-
-    std::vector<Region *> cache;
-    places = filterObjects(
+    SpatialHash ports(PORT_SPACING);
+    places = mg::filterObjects(
         mc->regions,
-        (filterFunc<Region>)[&](Region * r) {
+        [&](Region *r) {
           if (r->megaCluster->cities.size() == 0) {
             return false;
           }
@@ -480,27 +613,15 @@ void MapGenerator::makeCities() {
           if (!deep || r->city != nullptr) {
             return false;
           }
-          std::vector<Region *> seas;
-          getSea(&seas, r, r);
-          int sc = int(seas.size());
-
-          bool cond = (int)sc < b;
-
-          if (cond) {
-            for (auto cc : cache) {
-              if (mg::getDistance(r->site, cc->site) < 200) {
-                return false;
-              }
-            }
-
-            cache.push_back(r);
-          }
 
-          return cond;
-        },
-        (sortFunc<Region>)[&](Region * r, Region * r2) { return false; });
+          // Sheltered: a small sea, or a bay whose water stays close.
+          return r->seaArea < PORT_SEA_AREA || r->seaReach < PORT_SEA_REACH;
+        });
 
     for (auto r : places) {
+      if (ports.hasNear(r->site, PORT_SPACING)) {
+        continue;
+      }
       bool canPlace = true;
       for (auto n : r->neighbors) {
         if (n->city != nullptr) {
@@ -516,14 +637,15 @@ void MapGenerator::makeCities() {
       map->cities.push_back(c);
       mc->cities.push_back(c);
       mc->hasPort = true;
+      ports.insert(r);
     }
   }
 
   for (auto mc : map->megaClusters) {
     if (!mc->hasPort && mc->cities.size() > 0) {
-      places = filterObjects(
+      places = mg::filterObjects(
           mc->regions,
-          (filterFunc<Region>)[&](Region * r) {
+          [&](Region *r) {
 
             bool deep = false;
             for (auto n : r->neighbors) {
@@ -536,8 +658,7 @@ void MapGenerator::makeCities() {
               return false;
             }
             return true;
-          },
-          (sortFunc<Region>)[&](Region * r, Region * r2) { return false; });
+          });
 
       if (places.size() == 0) {
         continue;
@@ -869,6 +990,7 @@ void MapGenerator::makeRegions() {
     region->humidity = biom::DEFAULT_HUMIDITY;
     region->border = false;
     region->hasRiver = false;
+    region->id = map->regions.size();
     map->regions.push_back(region);
     _cells.insert(std::make_pair(c, region));
   }
@@ -886,13 +1008,17 @@ bool isDiscard(const Cluster *c) { return c->regions.size() == 0; }
 void MapGenerator::calcTemp() {
   map->status = "Making world cool...";
   for (auto r : map->regions) {
+    float lt = 0.f;
+    if (climate) {
+      lt = temperature * biom::LATITUDE_TEMPERATURE * getLatitude(r);
+    }
     if (!r->megaCluster->isLand) {
-      r->temperature = temperature + 5;
+      r->temperature = temperature + 5 - lt;
       continue;
     }
     // TODO: adjust it
     r->temperature = temperature - (temperature / 5 * r->humidity) -
-                     (temperature / 1.2 * r->getHeight(r->site));
+                     (temperature / 1.2 * r->getHeight(r->site)) - lt;
     Cell *c = r->cell;
     for (auto n : c->getNeighbors()) {
       if (_cells[n]->biom.name == biom::LAKE.name) {
@@ -944,6 +1070,84 @@ void MapGenerator::calcHumidity() {
   std::reverse(map->regions.begin(), map->regions.end());
 }
 
+// 0 on the equator (middle of the map), 1 on the top and bottom edges
+float MapGenerator::getLatitude(Region *r) {
+  return std::min(1.f, std::abs(float(r->site->y) / _h - 0.5f) * 2.f);
+}
+
+// Prevailing winds by latitude band: trade winds and polar winds blow
+// westward, the middle band blows eastward.
+// Regions are bucketed by x and swept downwind, so every region sees its
+// upwind neighbors already processed and the whole pass stays linear.
+void MapGenerator::makeClimate() {
+  map->status = "Blowing winds...";
+  std::vector<std::vector<Region *>> columns(_w + 1);
+  for (auto r : map->regions) {
+    r->moisture = -1.f;
+    int x = std::max(0, std::min(_w, int(r->site->x)));
+    columns[x].push_back(r);
+  }
+
+  auto getWind = [&](Region *r) {
+    float l = getLatitude(r);
+    return (l > 1.f / 3.f && l < 2.f / 3.f) ? 1 : -1;
+  };
+
+  auto blow = [&](Region *r, int wind) {
+    float h = r->getHeight(r->site);
+    float incoming = 0.f;
+    float uh = 0.f;
+    int n = 0;
+    for (auto rn : r->neighbors) {
+      if (rn->moisture < 0 || (rn->site->x - r->site->x) * wind >= 0) {
+        continue;
+      }
+      incoming += rn->moisture;
+      uh += rn->getHeight(rn->site);
+      n++;
+    }
+    if (n == 0) {
+      incoming = r->megaCluster->isLand ? biom::INLAND_MOISTURE : 1.f;
+      uh = h;
+    } else {
+      incoming /= n;
+      uh /= n;
+    }
+
+    if (!r->megaCluster->isLand) {
+      r->moisture = std::min(1.f, incoming + biom::EVAPORATION);
+      return;
+    }
+
+    float lift = std::max(0.f, h - uh);
+    float rain = std::min(incoming, incoming * (biom::PRECIPITATION +
+                                                biom::OROGRAPHIC_PRECIPITATION *
+                                                    lift));
+    r->moisture = incoming - rain;
+    if (r->hasRiver || r->biom.name == biom::LAKE.name) {
+      r->moisture = std::min(1.f, r->moisture + biom::EVAPORATION / 2.f);
+    }
+
+    float wet = std::min(1.f, incoming + rain);
+    r->humidity = std::min(0.9f, (r->humidity + wet) / 2.f);
+  };
+
+  for (int x = 0; x <= _w; x++) {
+    for (auto r : columns[x]) {
+      if (getWind(r) > 0) {
+        blow(r, 1);
+      }
+    }
+  }
+  for (int x = _w; x >= 0; x--) {
+    for (auto r : columns[x]) {
+      if (getWind(r) < 0) {
+        blow(r, -1);
+      }
+    }
+  }
+}
+
 std::vector<Cluster *> MapGenerator::clusterize(std::vector<Region *> regions,
                                                 sameFunc isNotSame,
                                                 assignFunc assignCluster,
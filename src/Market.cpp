@@ -0,0 +1,43 @@
+#include "mapgen/Market.hpp"
+
+// Sellers of each good are sorted by price once per buyer; prices only
+// depend on roads and states, which do not change during the simulation.
+// Expects city ids to be assigned by the TradeMatrix built over the same
+// cities.
+Market::Market(std::vector<City *> c) : cities(c) {
+  std::vector<City *> producers[2];
+  for (auto c : cities) {
+    if (c->type == MINE) {
+      producers[MINERALS].push_back(c);
+    } else if (c->type == AGRO) {
+      producers[AGROCULTURE].push_back(c);
+    }
+  }
+
+  for (int t = 0; t < 2; t++) {
+    suppliers[t].resize(cities.size());
+    for (auto buyer : cities) {
+      std::vector<std::pair<float, City *>> prices;
+      for (auto seller : producers[t]) {
+        if (seller != buyer) {
+          prices.push_back(std::make_pair(buyer->getPrice(seller), seller));
+        }
+      }
+      std::stable_sort(prices.begin(), prices.end(),
+                       [](const std::pair<float, City *> &p1,
+                          const std::pair<float, City *> &p2) {
+                         return p1.first < p2.first;
+                       });
+      auto &s = suppliers[t][buyer->id];
+      s.reserve(prices.size());
+      for (auto &p : prices) {
+        s.push_back(p.second);
+      }
+    }
+  }
+}
+
+const std::vector<City *> &Market::getSuppliers(City *buyer,
+                                                PackageType type) {
+  return suppliers[type][buyer->id];
+}
@@ -18,21 +18,6 @@
 
 #include <cmath>
 
-// TODO: move ints to utils.cpp
-template <typename T> using filterFunc = std::function<bool(T *)>;
-template <typename T> using sortFunc = std::function<bool(T *, T *)>;
-
-template <typename T>
-std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
-                               sortFunc<T> sort) {
-  std::vector<T *> places;
-
-  std::copy_if(regions.begin(), regions.end(), std::back_inserter(places),
-               filter);
-  std::sort(places.begin(), places.end(), sort);
-  return places;
-}
-
 class Painter {
 public:
   // TODO: use map instead mapgen
@@ -301,10 +286,9 @@ public:
   }
 
   sw::Spline *drawRoad(Road *r) {
-    sw::Spline *road = new sw::Spline();
-    if (r->spline != nullptr) {
-      road = r->spline;
-    } else {
+    sw::Spline *road = r->spline;
+    if (road == nullptr) {
+      road = new sw::Spline();
       int i = 0;
       road->setColor(sf::Color(200, 160, 100, 70));
       road->setThickness(1);
@@ -446,9 +430,9 @@ public:
   }
 
   void drawBorders() {
-    auto ends = filterObjects(
+    auto ends = mg::filterObjects(
         mapgen->map->regions,
-        (filterFunc<Region>)[&](Region * r) {
+        [&](Region *r) {
           if (r->stateBorder && !r->seaBorder &&
               std::count_if(r->neighbors.begin(), r->neighbors.end(),
                             [&](Region *n) {
@@ -458,8 +442,7 @@ public:
             return true;
           }
           return false;
-        },
-        (sortFunc<Region>)[&](Region * r, Region * r2) { return false; });
+        });
 
     std::vector<Region *> used;
     std::vector<Region *> exclude;
@@ -504,9 +487,9 @@ public:
       used->push_back(r);
     }
 
-    auto ns = filterObjects(
+    auto ns = mg::filterObjects(
         r->neighbors,
-        (filterFunc<Region>)[&](Region * n) {
+        [&](Region *n) {
           if (n->stateBorder && !n->seaBorder &&
               std::count(used->begin(), used->end(), n) == 0 &&
               std::count(exclude->begin(), exclude->end(), n) == 0 &&
@@ -515,7 +498,7 @@ public:
           }
           return false;
         },
-        (sortFunc<Region>)[&](Region * r, Region * r2) { return false; });
+        1);
 
     if (ns.size() > 0) {
       nextBorder(ns[0], used, line, ends, exclude);
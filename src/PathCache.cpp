@@ -0,0 +1,86 @@
+#include "mapgen/PathCache.hpp"
+
+PathCache::PathCache(Map *m, int n)
+    : map(m), shards(n), hits(0), misses(0), count(0) {}
+
+unsigned long long PathCache::key(int start, int end) {
+  return (unsigned long long)start << 32 | (unsigned int)end;
+}
+
+PathCache::Shard &PathCache::shard(unsigned long long k) {
+  return shards[std::hash<unsigned long long>()(k) % shards.size()];
+}
+
+bool PathCache::lookup(int start, int end, Entry &e) {
+  auto k = key(start, end);
+  auto &s = shard(k);
+  std::lock_guard<std::mutex> guard(s.lock);
+  auto it = s.entries.find(k);
+  if (it == s.entries.end()) {
+    return false;
+  }
+  e = it->second;
+  return true;
+}
+
+bool PathCache::find(Region *start, Region *end,
+                     micropather::MPVector<void *> *path, float *cost) {
+  Entry e;
+  if (start == end || !lookup(start->id, end->id, e)) {
+    misses++;
+    return false;
+  }
+  path->clear();
+  *cost = e.step;
+  path->push_back(start);
+  int steps = map->regions.size();
+  while (e.next != end->id) {
+    Region *r = map->regions[e.next];
+    path->push_back(r);
+    if (--steps == 0 || !lookup(r->id, end->id, e)) {
+      misses++;
+      return false;
+    }
+    *cost += e.step;
+  }
+  path->push_back(end);
+  hits++;
+  return true;
+}
+
+void PathCache::add(const std::vector<void *> &path) {
+  int n = path.size();
+  if (n < 2) {
+    return;
+  }
+  int end = ((Region *)path[n - 1])->id;
+  for (int i = 0; i < n - 1; i++) {
+    float step = 0.f;
+    auto r = (Region *)path[i];
+    for (auto e = map->edgesBegin(r); e != map->edgesEnd(r); e++) {
+      if (e->state == path[i + 1]) {
+        step = e->cost;
+        break;
+      }
+    }
+    auto k = key(r->id, end);
+    auto &s = shard(k);
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (s.entries.insert(std::make_pair(
+                              k, Entry{((Region *)path[i + 1])->id, step}))
+            .second) {
+      count++;
+    }
+  }
+}
+
+void PathCache::getCacheData(micropather::CacheData *data) {
+  int bytes = count * (sizeof(unsigned long long) + sizeof(Entry));
+  data->nBytesAllocated = bytes;
+  data->nBytesUsed = bytes;
+  data->memoryFraction = bytes > 0 ? 1.f : 0.f;
+  data->hit = hits;
+  data->miss = misses;
+  data->hitFraction =
+      hits + misses > 0 ? float(hits) / float(hits + misses) : 0.f;
+}
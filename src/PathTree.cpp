@@ -0,0 +1,85 @@
+#include "mapgen/PathTree.hpp"
+#include <limits>
+#include <queue>
+
+PathTree::PathTree(Map *m) : map(m) {
+  int n = map->regions.size();
+  stamp.assign(n, 0);
+  goal.assign(n, 0);
+  closed.assign(n, false);
+  cost.assign(n, 0.f);
+  prev.assign(n, nullptr);
+}
+
+void PathTree::touch(int id) {
+  if (stamp[id] != generation) {
+    stamp[id] = generation;
+    closed[id] = false;
+    cost[id] = std::numeric_limits<float>::max();
+    prev[id] = nullptr;
+  }
+}
+
+// Expands until every target is settled or the source's component is
+// exhausted.
+void PathTree::expand(Region *s, const std::vector<Region *> &targets) {
+  generation++;
+  source = s;
+  int left = 0;
+  for (auto t : targets) {
+    if (goal[t->id] != generation) {
+      goal[t->id] = generation;
+      left++;
+    }
+  }
+
+  typedef std::pair<float, Region *> Item;
+  auto later = [](const Item &a, const Item &b) { return a.first > b.first; };
+  std::priority_queue<Item, std::vector<Item>, decltype(later)> queue(later);
+  touch(s->id);
+  cost[s->id] = 0.f;
+  queue.push(std::make_pair(0.f, s));
+  while (!queue.empty() && left > 0) {
+    auto top = queue.top();
+    queue.pop();
+    Region *u = top.second;
+    if (closed[u->id]) {
+      continue;
+    }
+    closed[u->id] = true;
+    expanded++;
+    if (goal[u->id] == generation) {
+      left--;
+    }
+
+    adjacent.clear();
+    map->AdjacentCost(u, &adjacent);
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      Region *v = (Region *)adjacent[i].state;
+      touch(v->id);
+      float c = cost[u->id] + adjacent[i].cost;
+      if (!closed[v->id] && c < cost[v->id]) {
+        cost[v->id] = c;
+        prev[v->id] = u;
+        queue.push(std::make_pair(c, v));
+      }
+    }
+  }
+}
+
+bool PathTree::reached(Region *r) {
+  return stamp[r->id] == generation && closed[r->id];
+}
+
+float PathTree::getCost(Region *r) { return cost[r->id]; }
+
+void PathTree::getPath(Region *target, micropather::MPVector<void *> *path) {
+  path->clear();
+  std::vector<Region *> reversed;
+  for (Region *r = target; r != nullptr; r = prev[r->id]) {
+    reversed.push_back(r);
+  }
+  for (auto it = reversed.rbegin(); it != reversed.rend(); ++it) {
+    path->push_back(*it);
+  }
+}
@@ -8,7 +8,7 @@ Road::Road(micropather::MPVector<void *>* path, float c) : cost(c){
     auto ptr = (*path)[k];
     Region *r = (Region *)ptr;
     regions.push_back(r);
-    r->hasRoad = true;
-    r->traffic += 1;
   }
 };
+
+Road::~Road() { delete spline; }
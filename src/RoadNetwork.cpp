@@ -0,0 +1,163 @@
+#include "mapgen/RoadNetwork.hpp"
+#include "mapgen/utils.hpp"
+#include <limits>
+#include <queue>
+
+const float NO_LINK = std::numeric_limits<float>::max();
+
+RoadNetwork::RoadNetwork(std::vector<City *> c, float ratio)
+    : cities(c), size(c.size()), adjacent(c.size()), dist(c.size()),
+      stamp(c.size(), 0) {
+  std::vector<float> d(size * size, NO_LINK);
+  for (int i = 0; i < size; i++) {
+    for (int j = i + 1; j < size; j++) {
+      if (canLink(cities[i], cities[j])) {
+        d[i * size + j] = d[j * size + i] = mg::getDistance(
+            cities[i]->region->site, cities[j]->region->site);
+      }
+    }
+  }
+
+  // Prim over the dense distance matrix, restarted for every component.
+  std::vector<bool> inTree(size, false);
+  std::vector<float> best(size, NO_LINK);
+  std::vector<int> from(size, -1);
+  for (int k = 0; k < size; k++) {
+    int u = -1;
+    for (int i = 0; i < size; i++) {
+      if (!inTree[i] && (u == -1 || best[i] < best[u])) {
+        u = i;
+      }
+    }
+    inTree[u] = true;
+    if (from[u] != -1) {
+      addEdge(from[u], u, best[u]);
+    }
+    for (int v = 0; v < size; v++) {
+      if (!inTree[v] && d[u * size + v] < best[v]) {
+        best[v] = d[u * size + v];
+        from[v] = u;
+      }
+    }
+  }
+
+  std::vector<std::pair<float, int>> pairs;
+  for (int i = 0; i < size; i++) {
+    for (int j = i + 1; j < size; j++) {
+      if (d[i * size + j] != NO_LINK) {
+        pairs.push_back(std::make_pair(d[i * size + j], i * size + j));
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+
+  // Greedy spanner: shortest pairs first, each checked with a search that
+  // gives up once the detour is already too long.
+  int shortcuts = 0;
+  for (auto &p : pairs) {
+    int i = p.second / size;
+    int j = p.second % size;
+    if (bounded(i, j, ratio * p.first) != NO_LINK) {
+      continue;
+    }
+    addEdge(i, j, p.first);
+    shortcuts++;
+  }
+
+  countUsage();
+  mg::info("Road network edges:", edges.size());
+  mg::info("Road network shortcuts:", shortcuts);
+}
+
+bool RoadNetwork::canLink(City *c, City *oc) {
+  if (c->region->megaCluster == oc->region->megaCluster) {
+    return true;
+  }
+  return c->type == PORT && oc->type == PORT;
+}
+
+void RoadNetwork::addEdge(int i, int j, float d) {
+  adjacent[i].push_back(edges.size());
+  adjacent[j].push_back(edges.size());
+  edges.push_back(std::make_pair(cities[i], cities[j]));
+  links.push_back(std::make_pair(i, j));
+  lengths.push_back(d);
+}
+
+void RoadNetwork::shortest(int s, std::vector<float> &dist,
+                           std::vector<int> &prev) {
+  dist.assign(size, NO_LINK);
+  prev.assign(size, -1);
+  typedef std::pair<float, int> Item;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+  dist[s] = 0;
+  queue.push(std::make_pair(0.f, s));
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    int u = top.second;
+    if (top.first > dist[u]) {
+      continue;
+    }
+    for (int e : adjacent[u]) {
+      int v = links[e].first == u ? links[e].second : links[e].first;
+      float nd = dist[u] + lengths[e];
+      if (nd < dist[v]) {
+        dist[v] = nd;
+        prev[v] = e;
+        queue.push(std::make_pair(nd, v));
+      }
+    }
+  }
+}
+
+// Network distance from s to t, or NO_LINK if it is longer than limit.
+float RoadNetwork::bounded(int s, int t, float limit) {
+  generation++;
+  typedef std::pair<float, int> Item;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+  stamp[s] = generation;
+  dist[s] = 0;
+  queue.push(std::make_pair(0.f, s));
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    int u = top.second;
+    if (top.first > dist[u]) {
+      continue;
+    }
+    if (top.first > limit) {
+      break;
+    }
+    if (u == t) {
+      return top.first;
+    }
+    for (int e : adjacent[u]) {
+      int v = links[e].first == u ? links[e].second : links[e].first;
+      float nd = dist[u] + lengths[e];
+      if (nd <= limit && (stamp[v] != generation || nd < dist[v])) {
+        stamp[v] = generation;
+        dist[v] = nd;
+        queue.push(std::make_pair(nd, v));
+      }
+    }
+  }
+  return NO_LINK;
+}
+
+void RoadNetwork::countUsage() {
+  usage.assign(edges.size(), 0);
+  std::vector<float> dist;
+  std::vector<int> prev;
+  for (int s = 0; s < size; s++) {
+    shortest(s, dist, prev);
+    for (int t = s + 1; t < size; t++) {
+      int v = t;
+      while (prev[v] != -1) {
+        int e = prev[v];
+        usage[e]++;
+        v = links[e].first == v ? links[e].second : links[e].first;
+      }
+    }
+  }
+}
@@ -0,0 +1,169 @@
+#include "mapgen/SeaLanes.hpp"
+#include "mapgen/Map.hpp"
+#include "mapgen/utils.hpp"
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+const float UNREACHED = std::numeric_limits<float>::max();
+
+SeaLanes::SeaLanes(Map *map)
+    : seaOf(map->regions.size(), -1), localOf(map->regions.size(), -1),
+      outgoing(map->regions.size()), incoming(map->regions.size()) {
+  std::unordered_map<MegaCluster *, int> index;
+  for (auto r : map->regions) {
+    if (r->megaCluster->isLand || r->biom.name == "Lake") {
+      continue;
+    }
+    auto it = index.find(r->megaCluster);
+    if (it == index.end()) {
+      it = index.insert(std::make_pair(r->megaCluster, int(seas.size())))
+               .first;
+      seas.emplace_back();
+    }
+    seaOf[r->id] = it->second;
+    localOf[r->id] = seas[it->second].regions.size();
+    seas[it->second].regions.push_back(r);
+  }
+
+  MP_VECTOR<micropather::StateCost> adjacent;
+  for (auto r : map->regions) {
+    if (r->city == nullptr || r->city->type != PORT ||
+        !r->megaCluster->isLand) {
+      continue;
+    }
+    adjacent.clear();
+    map->AdjacentCost(r, &adjacent);
+    std::vector<int> touched;
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      int s = seaOf[((Region *)adjacent[i].state)->id];
+      if (s != -1 && std::find(touched.begin(), touched.end(), s) ==
+                         touched.end()) {
+        touched.push_back(s);
+        cross(map, r, s);
+      }
+    }
+  }
+  mg::info("Sea lanes:", laneCount);
+}
+
+// Dijkstra from port through sea s; every port reached on the far side
+// becomes a lane unless the direct land edge is cheaper.
+void SeaLanes::cross(Map *map, Region *port, int s) {
+  Sea &sea = seas[s];
+  int source = sea.prev.size();
+  sea.prev.emplace_back(sea.regions.size(), -1);
+  std::vector<int> &prev = sea.prev.back();
+  std::vector<float> dist(sea.regions.size(), UNREACHED);
+
+  typedef std::pair<float, int> Item;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+  MP_VECTOR<micropather::StateCost> adjacent;
+  map->AdjacentCost(port, &adjacent);
+  for (unsigned int i = 0; i < adjacent.size(); i++) {
+    int v = ((Region *)adjacent[i].state)->id;
+    if (seaOf[v] == s && adjacent[i].cost < dist[localOf[v]]) {
+      dist[localOf[v]] = adjacent[i].cost;
+      queue.push(std::make_pair(adjacent[i].cost, localOf[v]));
+    }
+  }
+
+  std::unordered_map<Region *, std::pair<float, int>> landings;
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    int u = top.second;
+    if (top.first > dist[u]) {
+      continue;
+    }
+    adjacent.clear();
+    map->AdjacentCost(sea.regions[u], &adjacent);
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      Region *n = (Region *)adjacent[i].state;
+      float c = dist[u] + adjacent[i].cost;
+      if (seaOf[n->id] == s) {
+        int v = localOf[n->id];
+        if (c < dist[v]) {
+          dist[v] = c;
+          prev[v] = u;
+          queue.push(std::make_pair(c, v));
+        }
+      } else if (n != port && n->megaCluster->isLand) {
+        auto it = landings.find(n);
+        if (it == landings.end() || c < it->second.first) {
+          landings[n] = std::make_pair(c, u);
+        }
+      }
+    }
+  }
+
+  adjacent.clear();
+  map->AdjacentCost(port, &adjacent);
+  for (auto &l : landings) {
+    bool direct = false;
+    for (unsigned int i = 0; i < adjacent.size(); i++) {
+      if (adjacent[i].state == l.first && adjacent[i].cost <= l.second.first) {
+        direct = true;
+      }
+    }
+    if (direct) {
+      continue;
+    }
+    Lane *lane = find(port, l.first);
+    if (lane != nullptr) {
+      if (lane->cost <= l.second.first) {
+        continue;
+      }
+      *lane = {l.first, l.second.first, s, source, l.second.second};
+      for (auto &in : incoming[l.first->id]) {
+        if (in.port == port) {
+          in = {port, l.second.first, s, source, l.second.second};
+        }
+      }
+      continue;
+    }
+    outgoing[port->id].push_back(
+        {l.first, l.second.first, s, source, l.second.second});
+    incoming[l.first->id].push_back(
+        {port, l.second.first, s, source, l.second.second});
+    laneCount++;
+  }
+}
+
+SeaLanes::Lane *SeaLanes::find(Region *from, Region *to) {
+  for (auto &lane : outgoing[from->id]) {
+    if (lane.port == to) {
+      return &lane;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<SeaLanes::Lane> &SeaLanes::getOutgoing(Region *port) {
+  return outgoing[port->id];
+}
+
+std::vector<SeaLanes::Lane> &SeaLanes::getIncoming(Region *port) {
+  return incoming[port->id];
+}
+
+bool SeaLanes::hasLane(Region *from, Region *to) {
+  return find(from, to) != nullptr;
+}
+
+void SeaLanes::expand(Region *from, Region *to, std::vector<void *> &path) {
+  Lane *lane = find(from, to);
+  if (lane == nullptr) {
+    return;
+  }
+  Sea &sea = seas[lane->sea];
+  std::vector<int> &prev = sea.prev[lane->source];
+  size_t start = path.size();
+  for (int v = lane->last; v != -1; v = prev[v]) {
+    path.push_back(sea.regions[v]);
+  }
+  std::reverse(path.begin() + start, path.end());
+}
+
+int SeaLanes::getLaneCount() { return laneCount; }
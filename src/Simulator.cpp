@@ -1,39 +1,57 @@
 #include "mapgen/Simulator.hpp"
+#include "mapgen/BatchSimulator.hpp"
+#include "mapgen/BidirectionalSearch.hpp"
 #include "mapgen/Biom.hpp"
+#include "mapgen/ClusterPather.hpp"
+#include "mapgen/ContractionHierarchy.hpp"
 #include "mapgen/Economy.hpp"
+#include "mapgen/EconomyRun.hpp"
+#include "mapgen/IncrementalPath.hpp"
+#include "mapgen/Isochrone.hpp"
+#include "mapgen/Market.hpp"
 #include "mapgen/Package.hpp"
+#include "mapgen/PathCache.hpp"
+#include "mapgen/PathTree.hpp"
 #include "mapgen/Region.hpp"
 #include "mapgen/Report.hpp"
+#include "mapgen/RoadNetwork.hpp"
+#include "mapgen/SpatialHash.hpp"
+#include "mapgen/TradeMatrix.hpp"
 #include "mapgen/names.hpp"
 #include "mapgen/utils.hpp"
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <functional>
-#include <mutex>
+#include <limits>
+#include <memory>
 #include <thread>
-#include <numeric>
 
-template <typename T> using filterFunc = std::function<bool(T *)>;
-template <typename T> using sortFunc = std::function<bool(T *, T *)>;
-
-template <typename T>
-std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
-                               sortFunc<T> sort) {
-  std::vector<T *> places;
-
-  std::copy_if(regions.begin(), regions.end(), std::back_inserter(places),
-               filter);
-  std::sort(places.begin(), places.end(), sort);
-  return places;
-}
+const float LIGHTHOUSE_SPACING = 100.f;
+const float FORT_SPACING = 20.f;
+const int FORT_ROADS = 2;
+const int FORTS_PER_STATE = 2;
+// City pairs each worker routes between two rounds of path cache inserts.
+const int ROAD_BATCH = 16;
 
 Simulator::Simulator(Map *m, int s) : map(m), _seed(s) {
   _gen = new std::mt19937(_seed);
   vars = new EconomyVars();
   report = nullptr;
+  market = nullptr;
+  trade = nullptr;
+  batch = nullptr;
+  economy = nullptr;
+  hierarchy = nullptr;
+  clusterPather = nullptr;
+  pathCache = nullptr;
 }
 
 void Simulator::simulate() {
-  report = new Report();
+  if (report == nullptr) {
+    report = new Report();
+  }
+  *report = Report();
   // TODO: reset all simulation results (caves, cities, etc)
   resetAll();
 
@@ -58,34 +76,71 @@ void Simulator::removeCities() {
   //     return c->roads.}), mapgen->map->cities.end());
 }
 
+// Everything the simulation creates (roads, caves, lighthouses, forts)
+// lives in the pools, so a reset unlinks it from the map in one sweep and
+// recycles the storage for the next run.
 void Simulator::resetAll() {
   map->status = "Reseting simulation results";
+  if (economy != nullptr) {
+    delete economy;
+    economy = nullptr;
+  }
+  if (market != nullptr) {
+    delete market;
+    delete trade;
+    market = nullptr;
+    trade = nullptr;
+  }
+  if (batch != nullptr) {
+    delete batch;
+    batch = nullptr;
+  }
+  if (hierarchy != nullptr) {
+    delete hierarchy;
+    hierarchy = nullptr;
+  }
+  if (clusterPather != nullptr) {
+    delete clusterPather;
+    clusterPather = nullptr;
+  }
+  if (pathCache != nullptr) {
+    delete pathCache;
+    pathCache = nullptr;
+  }
+  snapshots.clear();
+  stats.clear();
+
+  auto isFort = [](City *c) { return c->type == FORT; };
+  map->cities.erase(
+      std::remove_if(map->cities.begin(), map->cities.end(), isFort),
+      map->cities.end());
+  for (auto mc : map->megaClusters) {
+    mc->cities.erase(
+        std::remove_if(mc->cities.begin(), mc->cities.end(), isFort),
+        mc->cities.end());
+  }
   for (auto c : map->cities) {
     c->isCapital = false;
-    c->population = 1000;
-    c->wealth = 1.f;
+    c->population = Economy::INITIAL_POPULATION;
+    c->wealth = Economy::INITIAL_WEALTH;
+    c->roads.clear();
   }
   for (auto r : map->regions) {
-    if (r->city == nullptr && r->location != nullptr) {
-      map->locations.erase(std::remove(map->locations.begin(),
-                                       map->locations.end(), r->location));
-      r->location = nullptr;
-      r->city = nullptr;
-    }
-
-    if (r->city != nullptr && r->city->type == FORT) {
-      map->cities.erase(
-          std::remove(map->cities.begin(), map->cities.end(), r->city));
-      r->megaCluster->cities.erase(std::remove(r->megaCluster->cities.begin(),
-                                               r->megaCluster->cities.end(),
-                                               r->city));
+    if (r->location != nullptr && (r->city == nullptr || isFort(r->city))) {
       r->location = nullptr;
       r->city = nullptr;
     }
+    r->hasRoad = false;
+    r->traffic = 0;
   }
-  if (map->roads.size() > 0) {
-    fixRoads();
+  map->locations.clear();
+  map->roads.clear();
+
+  for (auto &pool : roadPools) {
+    pool.reset();
   }
+  locationPool.reset();
+  fortPool.reset();
 }
 
 void Simulator::fixRoads() {
@@ -140,34 +195,83 @@ void Simulator::fixRoads() {
 }
 
 void Simulator::simulateEconomy() {
-  int y = 1;
-  while (y <= years) {
+  if (market != nullptr) {
+    delete market;
+    delete trade;
+  }
+  trade = new TradeMatrix(map->cities, sparseRoads);
+  market = new Market(map->cities);
+
+  if (economy != nullptr) {
+    delete economy;
+  }
+  economy = new EconomyRun(market, trade, *vars, (*_gen)());
+  economy->verbose = true;
+  stepEconomy(years);
+}
+
+void Simulator::stepEconomy(int n) {
+  int last = economy->year + n;
+  while (economy->year < last) {
     char op[100];
-    sprintf(op, "Simulate economy [%d/%d]", y * 10, years * 10);
+    sprintf(op, "Simulate economy [%d/%d]", (economy->year + 1) * 10,
+            last * 10);
     map->status = op;
-    economyTick(y);
-    populationTick(y);
-    disasterTick(y);
-    y++;
+    economy->step();
+    disasterTick(economy->year);
   }
+  applyEconomy();
 }
 
-void Simulator::populationTick(int) {
-  int p = 0.f;
+void Simulator::applyEconomy() {
   for (auto c : map->cities) {
-    c->population *= (float)(1 +
-                             vars->POPULATION_GROWS * c->wealth *
-                                 vars->POPULATION_GROWS_WEALTH_MODIFIER);
-    c->population = std::max(c->population, 0);
-    p += c->population;
-    if (c->population > report->maxPopulation) {
-      report->maxPopulation = c->population;
-    }
-    if (c->population != 1000 && c->population < report->minPopulation) {
-      report->minPopulation = c->population;
-    }
+    c->population = economy->population[c->id];
+    c->wealth = economy->wealth[c->id];
+  }
+  *report = economy->report;
+}
+
+// Extends the last run by n years with the current vars, so a restored
+// snapshot can branch with different parameters.
+void Simulator::continueEconomy(int n) {
+  if (economy == nullptr) {
+    mg::warn("Continue simulation:", "run a simulation first");
+    return;
+  }
+  economy->vars = *vars;
+  stepEconomy(n);
+}
+
+void Simulator::saveSnapshot() {
+  if (economy == nullptr) {
+    return;
   }
-  report->population.push_back(p);
+  snapshots.push_back(economy->snapshot());
+  mg::info("Snapshot saved, bytes:", snapshots.back().data.size());
+}
+
+bool Simulator::restoreSnapshot(int i) {
+  if (economy == nullptr || i < 0 || i >= (int)snapshots.size()) {
+    return false;
+  }
+  if (!economy->restore(snapshots[i])) {
+    return false;
+  }
+  applyEconomy();
+  return true;
+}
+
+void Simulator::simulateBatch(std::vector<EconomyVars> runs) {
+  if (market == nullptr) {
+    mg::warn("Batch simulation:", "run a simulation first");
+    return;
+  }
+  if (batch != nullptr) {
+    delete batch;
+  }
+  map->status = "Simulate economy batch...";
+  batch = new BatchSimulator(market, trade, _seed);
+  batch->run(runs, years);
 }
 
 void Simulator::disasterTick(int) {
@@ -180,95 +284,204 @@ void Simulator::disasterTick(int) {
   // }
 }
 
-void Simulator::economyTick(int y) {
-  mg::info("Economy year:", y * 10);
-  std::vector<Package *> *goods = new std::vector<Package *>();
-  for (auto c : map->cities) {
-    c->economyVars = vars;
-    auto lg = c->makeGoods(y);
-	if (lg != nullptr) {
-		goods->push_back(lg);
-	}
-  }
-  unsigned int gc = std::accumulate(goods->begin(), goods->end(), 0,
-                            [](int s, Package *p2) { return s + p2->count; });
-  mg::info("Goods for sale:", gc);
-  std::shuffle(map->cities.begin(), map->cities.end(), *_gen);
-  unsigned int sn = 0;
-  for (auto c : map->cities) {
-    sn += c->buyGoods(goods);
-  }
-  mg::info("Still needs:", sn);
+float secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<float>(std::chrono::steady_clock::now() - start)
+      .count();
+}
 
-  float w = 0.f;
-  for (auto c : map->cities) {
-    w += c->wealth;
+bool solve(BidirectionalSearch *search, City *c, City *oc,
+           micropather::MPVector<void *> *path, float *totalCost) {
+  return search->getPath(c->region, oc->region, path, totalCost);
+}
+
+bool solve(ContractionHierarchy::Query *query, City *c, City *oc,
+           micropather::MPVector<void *> *path, float *totalCost) {
+  return query->getPath(c->region, oc->region, path, totalCost);
+}
 
-    if (c->wealth > report->maxWealth) {
-      report->maxWealth = c->wealth;
+bool solve(ClusterPather::Query *query, City *c, City *oc,
+           micropather::MPVector<void *> *path, float *totalCost) {
+  return query->getPath(c->region, oc->region, path, totalCost);
+}
+
+// A path that missed the cache is copied to solved, for the caller to add
+// to the cache later. The cache prices steps from the packed edges, which
+// only know lanes, so the copy is taken before water regions go back in.
+template <typename Solver>
+Road *makeRoad(Map *map, Solver *solver, PathCache *cache, Pool<Road> &pool,
+               City *c, City *oc, std::vector<void *> *solved) {
+  micropather::MPVector<void *> path;
+  float totalCost = 0;
+  if (!cache->find(c->region, oc->region, &path, &totalCost)) {
+    if (!solve(solver, c, oc, &path, &totalCost)) {
+      mg::warn("No road from", *c);
+      mg::warn("No road to", *oc);
+      return nullptr;
     }
-    if (c->wealth != 0.f && c->wealth < report->minWealth) {
-      report->minWealth = c->wealth;
+    for (unsigned int i = 0; i < path.size(); i++) {
+      solved->push_back(path[i]);
     }
   }
-  report->wealth.push_back(w);
+  map->expandSeaLanes(&path);
+  return pool.make(&path, totalCost);
 }
 
-Road *makeRoad(Map *map, City *c, City *oc) {
-  auto pather = new micropather::MicroPather(map);
-  micropather::MPVector<void *> path;
-  float totalCost = 0;
-  pather->Reset();
-  int result = pather->Solve(c->region, oc->region, &path, &totalCost);
-  if (result != micropather::MicroPather::SOLVED) {
-    mg::warn("No road from", *c);
-    mg::warn("No road to", *oc);
-    return nullptr;
-  }
-  Road *road = new Road(&path, totalCost);
-  return road;
+void countTraffic(Road *road, std::vector<int> &traffic, int weight) {
+  for (auto r : road->regions) {
+    traffic[r->id] += weight;
+  }
 }
 
+void addTraffic(Road *road) {
+  for (auto r : road->regions) {
+    r->hasRoad = true;
+    r->traffic++;
+  }
+}
+
+// Sums per-worker traffic histograms (indexed by region id) into the
+// regions once all paths are found.
+void Simulator::applyTraffic(std::vector<std::vector<int>> &traffic) {
+  for (auto r : map->regions) {
+    int t = 0;
+    for (auto &h : traffic) {
+      t += h[r->id];
+    }
+    if (t > 0) {
+      r->hasRoad = true;
+      r->traffic += t;
+    }
+  }
+}
+
+// City pairs are routed on a fixed pool of workers, each with its own
+// search and traffic histogram. Regions are not written until every path
+// is found, so road costs do not depend on thread timing. Pairs go out in
+// batches and the paths solved in a batch are added to the cache in pair
+// order after it, so cache hits do not depend on thread timing either. In
+// sparse mode
+// only the RoadNetwork edges are routed and each one counts as traffic for
+// every city pair that trades over it.
 void Simulator::makeRoads() {
+  auto start = std::chrono::steady_clock::now();
   map->roads.clear();
   map->status = "Making roads...";
   char op[100];
 
-  const int tc = (map->cities.size() * map->cities.size() - map->cities.size()) / 2;
-  int k = 0;
-  int n = 1;
-#ifdef _WIN32
-  std::thread threads[10000];
-#else
-  std::thread threads[tc];
-#endif
-  std::mutex g_lock;
-  for (auto c : map->cities) {
-    for (auto oc :
-         std::vector<City *>(map->cities.begin() + n, map->cities.end())) {
-      sprintf(op, "Making roads [%d/%d]", k, tc);
-      if (c == oc) {
-        continue;
+  std::vector<std::pair<City *, City *>> pairs;
+  std::vector<int> weights;
+  if (sparseRoads) {
+    RoadNetwork network(map->cities, detourRatio);
+    pairs = network.edges;
+    weights = network.usage;
+  } else {
+    for (size_t i = 0; i < map->cities.size(); i++) {
+      for (size_t j = i + 1; j < map->cities.size(); j++) {
+        pairs.push_back(std::make_pair(map->cities[i], map->cities[j]));
       }
-      map->status = op;
-      threads[k] = std::thread([&](City* c, City* oc) {
-        auto road = makeRoad(map, c, oc);
-        if (road == nullptr) {
-          return;
-        }
-        g_lock.lock();
-        map->roads.push_back(road);
-        g_lock.unlock();
-        }, c, oc);
-      k++;
-    };
-    n++;
-  };
-  for (int i = 0; i < tc; ++i) {
-    sprintf(op, "Finalize roads [%d/%d]", i, tc);
+    }
+    weights.assign(pairs.size(), 1);
+  }
+  const int tc = pairs.size();
+  std::vector<Road *> roads(tc, nullptr);
+  map->updateEdges(true);
+  if (hierarchy != nullptr) {
+    delete hierarchy;
+    hierarchy = nullptr;
+  }
+  if (clusterPather != nullptr) {
+    delete clusterPather;
+    clusterPather = nullptr;
+  }
+  if (useHierarchy) {
+    map->status = "Contracting region graph...";
+    hierarchy = new ContractionHierarchy(map);
+  } else if (useClusters) {
+    map->status = "Linking cluster portals...";
+    clusterPather = new ClusterPather(map);
+  }
+  if (pathCache != nullptr) {
+    delete pathCache;
+  }
+  pathCache = new PathCache(map);
+
+  int n = std::max(1, std::min(int(std::thread::hardware_concurrency()), tc));
+  roadPool(n - 1);
+  std::vector<std::vector<int>> traffic(n);
+  std::vector<std::unique_ptr<BidirectionalSearch>> searches(n);
+  std::vector<std::unique_ptr<ContractionHierarchy::Query>> queries(n);
+  std::vector<std::unique_ptr<ClusterPather::Query>> clusterQueries(n);
+  for (int t = 0; t < n; t++) {
+    traffic[t].assign(map->regions.size(), 0);
+    searches[t].reset(new BidirectionalSearch(map));
+    if (hierarchy != nullptr) {
+      queries[t].reset(new ContractionHierarchy::Query(hierarchy));
+    }
+    if (clusterPather != nullptr) {
+      clusterQueries[t].reset(new ClusterPather::Query(clusterPather));
+    }
+  }
+  std::vector<std::vector<void *>> solved(tc);
+  for (int first = 0; first < tc; first += n * ROAD_BATCH) {
+    const int last = std::min(tc, first + n * ROAD_BATCH);
+    sprintf(op, "Making roads [%d/%d]", first, tc);
     map->status = op;
-    threads[i].join();
+    std::atomic<int> next(first);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < n; t++) {
+      workers.push_back(std::thread([&](int t) {
+        int i;
+        while ((i = next++) < last) {
+          if (queries[t]) {
+            roads[i] = makeRoad(map, queries[t].get(), pathCache,
+                                roadPools[t], pairs[i].first, pairs[i].second,
+                                &solved[i]);
+          } else if (clusterQueries[t]) {
+            roads[i] = makeRoad(map, clusterQueries[t].get(), pathCache,
+                                roadPools[t], pairs[i].first, pairs[i].second,
+                                &solved[i]);
+          } else {
+            roads[i] = makeRoad(map, searches[t].get(), pathCache,
+                                roadPools[t], pairs[i].first, pairs[i].second,
+                                &solved[i]);
+          }
+          if (roads[i] != nullptr) {
+            countTraffic(roads[i], traffic[t], weights[i]);
+          }
+        }
+      }, t));
+    }
+    for (auto &w : workers) {
+      w.join();
+    }
+    for (int i = first; i < last; i++) {
+      pathCache->add(solved[i]);
+      solved[i].clear();
+    }
+  }
+
+  for (auto road : roads) {
+    if (road != nullptr) {
+      map->roads.push_back(road);
+    }
   }
+  applyTraffic(traffic);
+  StageStats s;
+  s.name = "makeRoads";
+  s.queries = tc;
+  for (int t = 0; t < n; t++) {
+    s.expanded += searches[t]->expanded;
+    if (queries[t]) {
+      s.expanded += queries[t]->expanded;
+    }
+    if (clusterQueries[t]) {
+      s.expanded += clusterQueries[t]->expanded;
+    }
+  }
+  pathCache->getCacheData(&s.cache);
+  mg::info("Path cache hits:", s.cache.hit);
+  mg::info("Path cache misses:", s.cache.miss);
+
   for (auto r : map->roads) {
     auto c1 = r->regions.front()->city;
     auto c2 = r->regions.back()->city;
@@ -280,6 +493,8 @@ void Simulator::makeRoads() {
     }
   }
   std::shuffle(map->roads.begin(), map->roads.end(), *_gen);
+  s.seconds = secondsSince(start);
+  stats.push_back(s);
 }
 
 void Simulator::makeCaves() {
@@ -297,7 +512,7 @@ void Simulator::makeCaves() {
       if (r->location != nullptr) {
         continue;
       }
-      Location *l = new Location(r, names::generateCityName(_gen), CAVE);
+      Location *l = locationPool.make(r, names::generateCityName(_gen), CAVE);
       map->locations.push_back(l);
       n--;
       i++;
@@ -310,15 +525,9 @@ void Simulator::upgradeCities() {
   map->status = "Upgrade cities...";
   std::vector<City *> _cities;
   for (auto state : map->states) {
-    _cities = filterObjects(
-        map->cities,
-        (filterFunc<City>)[&](City * c) { return c->region->state == state; },
-        (sortFunc<City>)[&](City * c, City * c2) {
-          if (c->wealth > c2->wealth) {
-            return true;
-          }
-          return false;
-        });
+    _cities = mg::topObjects(
+        map->cities, [&](City *c) { return c->region->state == state; },
+        [](City *c) { return c->wealth; }, 1);
 
     if (_cities.size() == 0) {
       continue;
@@ -364,20 +573,16 @@ void Simulator::removeBadPorts() {
   }
 }
 
+// Lighthouses only depend on the traffic of neighbouring sea regions and a
+// fixed spacing, so they need no travel costs.
 void Simulator::makeLighthouses() {
   map->status = "Make lighthouses...";
-  std::vector<Region *> cache;
+  SpatialHash cache(LIGHTHOUSE_SPACING);
   for (auto r : map->regions) {
     if (r->city != nullptr) {
       continue;
     }
-    bool tc = false;
-    for (auto cc : cache) {
-      if (mg::getDistance(r->site, cc->site) < 100) {
-        tc = true;
-      }
-    }
-    if (tc) {
+    if (cache.hasNear(r->site, LIGHTHOUSE_SPACING)) {
       continue;
     }
 
@@ -391,106 +596,221 @@ void Simulator::makeLighthouses() {
       }
     }
     if (i >= 3) {
-      Location *l = new Location(r, names::generateCityName(_gen), LIGHTHOUSE);
+      Location *l =
+          locationPool.make(r, names::generateCityName(_gen), LIGHTHOUSE);
       map->locations.push_back(l);
-      cache.push_back(l->region);
+      cache.insert(l->region);
     }
   }
 }
 
+// Each location is linked to the city on its own land mass that is
+// cheapest to reach it from, taken from one isochrone expansion per land
+// mass. Locations are grouped by city and each group is served by an
+// IncrementalPath rooted at that city, which repairs itself as each new
+// road makes edges cheaper. One search is reset for every city so its
+// scratch is not reallocated.
 void Simulator::makeLocationRoads() {
-
-  auto _pather = new micropather::MicroPather(map);
+  auto start = std::chrono::steady_clock::now();
+  map->updateEdges();
   map->status = "Make small roads...";
+  std::unordered_map<MegaCluster *, std::vector<Location *>> byCluster;
   for (auto l : map->locations) {
-    auto mc = l->region->megaCluster;
-    if (mc->cities.size() == 0) {
+    byCluster[l->region->megaCluster].push_back(l);
+  }
+
+  StageStats s;
+  s.name = "makeLocationRoads";
+  std::vector<City *> hubs;
+  std::vector<std::vector<Location *>> groups;
+  std::vector<Region *> sources;
+  Isochrone catchment(map);
+  for (auto mc : map->megaClusters) {
+    auto it = byCluster.find(mc);
+    if (it == byCluster.end()) {
       continue;
     }
-    std::sort(mc->cities.begin(), mc->cities.end(), [&](City *c, City *c2) {
-      if (mg::getDistance(l->region->site, c->region->site) <
-          mg::getDistance(l->region->site, c2->region->site)) {
-        return true;
+    int first = hubs.size();
+    sources.clear();
+    for (auto c : mc->cities) {
+      if (c->region->city != nullptr) {
+        hubs.push_back(c);
+        sources.push_back(c->region);
+        groups.emplace_back();
+      }
+    }
+    catchment.expand(sources, std::numeric_limits<float>::max(), mc);
+    s.catchment += catchment.regions.size();
+    for (auto l : it->second) {
+      if (catchment.reached(l->region)) {
+        groups[first + catchment.getSource(l->region)].push_back(l);
       }
-      return false;
-    });
-    int n = 0;
-    City *c = mc->cities[n];
-    while (c->region->city == nullptr) {
-      n++;
-      c = mc->cities[n];
-    }
-
-    micropather::MPVector<void *> path;
-    float totalCost = 0;
-    _pather->Reset();
-    int result = _pather->Solve(c->region, l->region, &path, &totalCost);
-    if (result != micropather::MicroPather::SOLVED) {
+    }
+  }
+
+  IncrementalPath search(map);
+  for (size_t i = 0; i < hubs.size(); i++) {
+    if (groups[i].empty()) {
       continue;
     }
-    Road *road = new Road(&path, 1);
-    map->roads.push_back(road);
+    search.reset(hubs[i]->region);
+    for (auto l : groups[i]) {
+      micropather::MPVector<void *> path;
+      float totalCost = 0;
+      s.queries++;
+      if (!search.getPath(l->region, &path, &totalCost)) {
+        continue;
+      }
+      map->expandSeaLanes(&path);
+      Road *road = roadPool(0).make(&path, 1);
+      addTraffic(road);
+      map->updateEdges(road);
+      for (auto r : road->regions) {
+        search.updateRegion(r);
+      }
+      map->roads.push_back(road);
+    }
   }
+  s.expanded = search.expanded;
+  s.seconds = secondsSince(start);
+  stats.push_back(s);
 }
 
+// Forts are placed first, then each one is connected by a single
+// shortest-path expansion to all of its targets. In sparse mode a fort's
+// targets are the FORT_ROADS cities cheapest to reach from it on its land
+// mass, from one bounded isochrone per fort. Expansions run in parallel,
+// one reusable PathTree per worker; roads are registered in fort order
+// afterwards.
 void Simulator::makeForts() {
+  auto start = std::chrono::steady_clock::now();
   map->status = "Make forts...";
-  // TODO: uncluster it too
-  std::vector<Region *> regions;
-  std::vector<Region *> cache;
+  std::vector<City *> forts;
+  std::vector<std::vector<City *>> targets;
+  auto cities = map->cities;
+  SpatialHash cache(FORT_SPACING);
   for (auto mc : map->megaClusters) {
     if (mc->states.size() < 2) {
       continue;
     }
 
     for (auto state : mc->states) {
-      regions = filterObjects(mc->regions,
-                              (filterFunc<Region>)[&](Region * region) {
-                                bool cond = region->stateBorder &&
-                                            !region->seaBorder &&
-                                            region->state == state;
-                                // if (cond && std::none_of(cache.begin(),
-                                // cache.end(), [&](Region *ri){
-                                //       for (auto rn : cache) {
-                                //         if (mg::getDistance(ri->site,
-                                //         rn->site) < 20 && ri->state ==
-                                //         rn->state) {
-                                //           return true;
-                                //         }
-                                //       }
-                                //       return false;
-                                //     })) {
-                                //   cache.push_back(region);
-                                // } else {
-                                //   return false;
-                                // }
-                                return cond;
-                              },
-                              (sortFunc<Region>)[&](Region * r, Region * r2) {
-                                if (r->traffic > r2->traffic) {
-                                  return true;
-                                }
-                                return false;
-                              });
-
       int n = 0;
-      while (n < std::min(2, int(regions.size()))) {
-        City *c = new City(regions[n], names::generateCityName(_gen), FORT);
-        for (auto oc : map->cities) {
-          auto road = makeRoad(map, c, oc);
-          if (road == nullptr) {
+      mg::visitTopObjects(
+          mc->regions,
+          [&](Region *region) {
+            return region->stateBorder && !region->seaBorder &&
+                   region->state == state;
+          },
+          [](Region *r) { return r->traffic; },
+          [&](Region *region) {
+            if (cache.hasNear(region->site, FORT_SPACING,
+                              [&](Region *r) { return r->state == state; })) {
+              return true;
+            }
+            cache.insert(region);
+            City *c =
+                fortPool.make(region, names::generateCityName(_gen), FORT);
+            targets.push_back(sparseRoads ? std::vector<City *>() : cities);
+            cities.push_back(c);
+            forts.push_back(c);
+            mc->cities.push_back(c);
+            return ++n < FORTS_PER_STATE;
+          });
+    }
+  }
+
+  const int fc = forts.size();
+  std::vector<std::vector<Road *>> roads(fc);
+  map->updateEdges();
+  if (sparseRoads) {
+    std::vector<Region *> sources;
+    for (auto c : forts) {
+      sources.push_back(c->region);
+    }
+    auto nearest = Isochrone::nearestEach(map, sources, FORT_ROADS,
+                                          [](Region *r) {
+                                            return r->city != nullptr &&
+                                                   r->city->type != FORT;
+                                          });
+    for (int i = 0; i < fc; i++) {
+      for (auto r : nearest[i]) {
+        targets[i].push_back(r->city);
+      }
+    }
+  }
+  int n = std::max(1, std::min(int(std::thread::hardware_concurrency()), fc));
+  std::vector<long> expanded(n, 0);
+  roadPool(n - 1);
+  std::atomic<int> next(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < n; t++) {
+    workers.push_back(std::thread([&](int t) {
+      PathTree tree(map);
+      std::vector<Region *> goals;
+      int i;
+      while ((i = next++) < fc) {
+        goals.clear();
+        for (auto oc : targets[i]) {
+          goals.push_back(oc->region);
+        }
+        tree.expand(forts[i]->region, goals);
+        for (auto oc : targets[i]) {
+          if (!tree.reached(oc->region)) {
+            roads[i].push_back(nullptr);
             continue;
           }
-          map->roads.push_back(road);
-          c->roads.push_back(road);
-          oc->roads.push_back(road);
+          micropather::MPVector<void *> path;
+          tree.getPath(oc->region, &path);
+          map->expandSeaLanes(&path);
+          roads[i].push_back(
+              roadPools[t].make(&path, tree.getCost(oc->region)));
         }
-        map->cities.push_back(c);
-        mc->cities.push_back(c);
-        n++;
       }
+      expanded[t] = tree.expanded;
+    }, t));
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  for (int i = 0; i < fc; i++) {
+    City *c = forts[i];
+    for (size_t k = 0; k < targets[i].size(); k++) {
+      City *oc = targets[i][k];
+      Road *road = roads[i][k];
+      if (road == nullptr) {
+        mg::warn("No road from", *c);
+        mg::warn("No road to", *oc);
+        continue;
+      }
+      addTraffic(road);
+      map->roads.push_back(road);
+      c->roads.push_back(road);
+      oc->roads.push_back(road);
     }
+    map->cities.push_back(c);
+  }
+  mg::info("Forts created:", fc);
+  StageStats s;
+  s.name = "makeForts";
+  for (auto &t : targets) {
+    s.queries += t.size();
+  }
+  for (auto e : expanded) {
+    s.expanded += e;
+  }
+  s.seconds = secondsSince(start);
+  stats.push_back(s);
+}
+
+// One road pool per worker thread; grown before workers start so the
+// deque never changes while they run.
+Pool<Road> &Simulator::roadPool(int i) {
+  while ((int)roadPools.size() <= i) {
+    roadPools.emplace_back();
   }
+  return roadPools[i];
 }
 
 template <typename Iter> Iter Simulator::select_randomly(Iter start, Iter end) {
@@ -0,0 +1,52 @@
+#include "mapgen/SpatialHash.hpp"
+#include "mapgen/utils.hpp"
+#include <cmath>
+
+SpatialHash::SpatialHash(float cs) : cellSize(cs) {}
+
+unsigned long long SpatialHash::key(int x, int y) {
+  return ((unsigned long long)(unsigned int)x << 32) | (unsigned int)y;
+}
+
+void SpatialHash::insert(Region *r) {
+  int x = std::floor(r->site->x / cellSize);
+  int y = std::floor(r->site->y / cellSize);
+  cells[key(x, y)].push_back(r);
+  count++;
+}
+
+bool SpatialHash::hasNear(Point p, float radius) {
+  return hasNear(p, radius, [](Region *) { return true; });
+}
+
+bool SpatialHash::hasNear(Point p, float radius,
+                          std::function<bool(Region *)> filter) {
+  if (count == 0) {
+    return false;
+  }
+  int x0 = std::floor((p->x - radius) / cellSize);
+  int x1 = std::floor((p->x + radius) / cellSize);
+  int y0 = std::floor((p->y - radius) / cellSize);
+  int y1 = std::floor((p->y + radius) / cellSize);
+  for (int x = x0; x <= x1; x++) {
+    for (int y = y0; y <= y1; y++) {
+      auto cell = cells.find(key(x, y));
+      if (cell == cells.end()) {
+        continue;
+      }
+      for (auto r : cell->second) {
+        if (mg::getDistance(p, r->site) < radius && filter(r)) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void SpatialHash::clear() {
+  cells.clear();
+  count = 0;
+}
+
+int SpatialHash::size() { return count; }
@@ -1,5 +1,5 @@
 #include "mapgen/State.hpp"
 
-State::State(std::string n, sf::Color cl, Cell* c) : name(n), color(cl), cell(c) {
+State::State(int i, std::string n, sf::Color cl, Region* c) : id(i), name(n), color(cl), center(c) {
   
 }
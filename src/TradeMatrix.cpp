@@ -0,0 +1,138 @@
+#include "mapgen/TradeMatrix.hpp"
+#include "mapgen/utils.hpp"
+#include <limits>
+#include <queue>
+
+// Dense city-by-city prices and the ports along each trade route, filled
+// once after roads are built. With a full road network every pair trades
+// over its direct road; a sparse network has no such road for most pairs,
+// so routes there are shortest paths over the city road graph. Port lists
+// are packed in one flat vector indexed by portOffsets (row-major over
+// buyer, seller).
+TradeMatrix::TradeMatrix(std::vector<City *> c, bool sparse)
+    : cities(c), size(c.size()) {
+  for (int i = 0; i < size; i++) {
+    cities[i]->id = i;
+    cities[i]->trade = this;
+  }
+
+  prices.assign(size * size, 1.f);
+  portOffsets.assign(size * size + 1, 0);
+
+  std::vector<float> cost;
+  std::vector<Road *> via;
+  std::vector<int> seen(size, -1);
+  int missing = 0;
+  for (auto buyer : cities) {
+    if (sparse) {
+      route(buyer, cost, via);
+    } else {
+      direct(buyer, cost, via);
+    }
+    for (auto seller : cities) {
+      int i = index(buyer, seller);
+      portOffsets[i + 1] = portOffsets[i];
+      if (buyer == seller || buyer->roads.size() == 0) {
+        continue;
+      }
+
+      float price = 1.f;
+      if (via[seller->id] != nullptr) {
+        price *= 1 + (cost[seller->id] / 10000.f);
+        City *v = seller;
+        while (v != buyer) {
+          Road *road = via[v->id];
+          for (auto r : road->regions) {
+            City *p = r->city;
+            if (p != nullptr && p->type == PORT && p != buyer &&
+                p != seller && seen[p->id] != i) {
+              seen[p->id] = i;
+              ports.push_back(p);
+              portOffsets[i + 1]++;
+            }
+          }
+          v = other(road, v);
+        }
+      } else {
+        price *= 1.5;
+        missing++;
+      }
+      if (seller->region->state != buyer->region->state) {
+        price *= 1.5;
+      }
+      prices[i] = price;
+    }
+  }
+  if (missing > 0) {
+    mg::warn("Trade routes not found:", missing);
+  }
+}
+
+City *TradeMatrix::other(Road *road, City *c) {
+  City *front = road->regions.front()->city;
+  City *back = road->regions.back()->city;
+  return front == c ? back : (back == c ? front : nullptr);
+}
+
+// The first road from one city to each of its neighbours.
+void TradeMatrix::direct(City *from, std::vector<float> &cost,
+                         std::vector<Road *> &via) {
+  cost.assign(size, std::numeric_limits<float>::max());
+  via.assign(size, nullptr);
+  for (auto road : from->roads) {
+    City *v = other(road, from);
+    if (v == nullptr || v == from || !listed(v) || via[v->id] != nullptr) {
+      continue;
+    }
+    cost[v->id] = road->cost;
+    via[v->id] = road;
+  }
+}
+
+bool TradeMatrix::listed(City *c) {
+  return c->trade == this && c->id < size && cities[c->id] == c;
+}
+
+// Dijkstra from one city over roads between listed cities; via holds the
+// last road on the cheapest route to each city.
+void TradeMatrix::route(City *from, std::vector<float> &cost,
+                        std::vector<Road *> &via) {
+  cost.assign(size, std::numeric_limits<float>::max());
+  via.assign(size, nullptr);
+  typedef std::pair<float, int> Item;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+  cost[from->id] = 0;
+  queue.push(std::make_pair(0.f, from->id));
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    City *u = cities[top.second];
+    if (top.first > cost[u->id]) {
+      continue;
+    }
+    for (auto road : u->roads) {
+      City *v = other(road, u);
+      if (v == nullptr || v == u || !listed(v)) {
+        continue;
+      }
+      float nc = cost[u->id] + road->cost;
+      if (nc < cost[v->id]) {
+        cost[v->id] = nc;
+        via[v->id] = road;
+        queue.push(std::make_pair(nc, v->id));
+      }
+    }
+  }
+}
+
+int TradeMatrix::index(City *from, City *to) { return from->id * size + to->id; }
+
+float TradeMatrix::getPrice(City *buyer, City *seller) {
+  return prices[index(buyer, seller)];
+}
+
+PortRange TradeMatrix::getPorts(City *from, City *to) {
+  int i = index(from, to);
+  City **base = ports.data();
+  return {base + portOffsets[i], base + portOffsets[i + 1]};
+}
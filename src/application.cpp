@@ -20,6 +20,7 @@ class Application {
   int octaves;
   float freq;
   int nPoints;
+  int nStates;
   int seed;
   int t = 0;
   bool showUI = true;
@@ -102,6 +103,45 @@ public:
     });
   }
 
+  void continueSimulation() {
+    if (generator.joinable()) {
+      generator.join();
+    }
+    int n = simulationWindow->continueYears;
+    generator = std::thread([&, n]() {
+      ready = false;
+      mapgen->continueSimulation(n);
+      painter->update();
+      ready = mapgen->ready;
+    });
+  }
+
+  void restoreSnapshot() {
+    if (generator.joinable()) {
+      generator.join();
+    }
+    int i = simulationWindow->restoreIndex;
+    simulationWindow->restoreIndex = -1;
+    generator = std::thread([&, i]() {
+      ready = false;
+      mapgen->restoreSnapshot(i);
+      painter->update();
+      ready = mapgen->ready;
+    });
+  }
+
+  void simulateBatch() {
+    if (generator.joinable()) {
+      generator.join();
+    }
+    auto runs = simulationWindow->getBatchRuns();
+    generator = std::thread([&, runs]() {
+      ready = false;
+      mapgen->startBatch(runs);
+      ready = mapgen->ready;
+    });
+  }
+
   void initMapGen() {
     seed = std::chrono::system_clock::now().time_since_epoch().count();
     mapgen = new MapGenerator(window->getSize().x, window->getSize().y);
@@ -109,6 +149,7 @@ public:
     octaves = mapgen->getOctaveCount();
     freq = mapgen->getFrequency();
     nPoints = mapgen->getPointCount();
+    nStates = mapgen->getStatesCount();
     relax = mapgen->getRelax();
   }
 
@@ -227,6 +268,8 @@ public:
           mapgen->setFrequency(freq);
         }
 
+        ImGui::Checkbox("Wind climate", &mapgen->climate);
+
         if (ImGui::InputInt("Points", &nPoints)) {
           if (nPoints < 5) {
             nPoints = 5;
@@ -234,6 +277,10 @@ public:
           mapgen->setPointCount(nPoints);
         }
 
+        if (ImGui::SliderInt("States", &nStates, 1, 16)) {
+          mapgen->setStatesCount(nStates);
+        }
+
         if (ImGui::Button("Random")) {
           mapgen->seed();
           regen();
@@ -307,6 +354,9 @@ public:
 
     if (ImGui::AddTab("Simulation")) {
       simulationWindow->draw();
+      if (simulationWindow->restoreIndex != -1) {
+        restoreSnapshot();
+      }
 
       if (mapgen->simulator->report != nullptr) {
         if (ImGui::Button("Reset simulation")) {
@@ -317,6 +367,16 @@ public:
       if (ImGui::Button("Start simulation")) {
         simulate();
       }
+      if (mapgen->simulator->report != nullptr) {
+        ImGui::SameLine(150);
+        if (ImGui::Button("Run batch")) {
+          simulateBatch();
+        }
+        ImGui::SameLine(250);
+        if (ImGui::Button("Continue")) {
+          continueSimulation();
+        }
+      }
     }
     if (ImGui::AddTab("Objects")) {
       drawObjects();
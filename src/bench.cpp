@@ -0,0 +1,52 @@
+#include "mapgen/MapGenerator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// Generates maps at fixed seeds and sizes and times the road stages of the
+// simulation. Usage: mapgen-bench [max regions]
+// The table goes to stdout and the generator's log to stderr.
+const int WIDTH = 1600;
+const int HEIGHT = 900;
+const std::vector<int> SIZES = {1000, 10000, 100000};
+const std::vector<int> SEEDS = {1, 2, 3};
+
+int main(int argc, char **argv) {
+  int maxSize = argc > 1 ? std::atoi(argv[1]) : SIZES.back();
+  std::cout.rdbuf(std::cerr.rdbuf());
+  printf("%8s %6s %-18s %9s %8s %12s %10s %10s %8s\n", "regions", "seed",
+         "stage", "seconds", "queries", "expanded", "catchment", "queries/s",
+         "hit rate");
+  for (auto size : SIZES) {
+    if (size > maxSize) {
+      continue;
+    }
+    for (auto seed : SEEDS) {
+      MapGenerator mapgen(WIDTH, HEIGHT);
+      mapgen.setSeed(seed);
+      mapgen.setPointCount(size);
+      auto start = std::chrono::steady_clock::now();
+      mapgen.update();
+      float generate = std::chrono::duration<float>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      printf("%8d %6d %-18s %9.3f\n", size, seed, "generate", generate);
+      fflush(stdout);
+
+      mapgen.simulator->years = 0;
+      mapgen.startSimulation();
+      for (auto &s : mapgen.simulator->stats) {
+        char hitRate[16] = "n/a";
+        if (s.cache.hit + s.cache.miss > 0) {
+          snprintf(hitRate, sizeof(hitRate), "%.1f%%",
+                   s.cache.hitFraction * 100.f);
+        }
+        printf("%8d %6d %-18s %9.3f %8d %12ld %10ld %10.0f %8s\n", size, seed,
+               s.name.c_str(), s.seconds, s.queries, s.expanded, s.catchment,
+               s.seconds > 0 ? s.queries / s.seconds : 0.f, hitRate);
+      }
+      fflush(stdout);
+    }
+  }
+}
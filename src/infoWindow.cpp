@@ -38,6 +38,9 @@ void InfoWindow::draw(Region *currentRegion) {
     ImGui::Text("State border: %s", currentRegion->stateBorder ? "true" : "false");
     ImGui::Text("Has river: %s", currentRegion->hasRiver ? "true" : "false");
     ImGui::Text("Is border: %s", currentRegion->border ? "true" : "false");
+    ImGui::Text("Coast distance: %d", currentRegion->coastDistance);
+    ImGui::Text("Sea area: %d", currentRegion->seaArea);
+    ImGui::Text("Sea reach: %f", currentRegion->seaReach);
     ImGui::Text("\n");
 
     ImGui::Text("Site: x:%f y:%f z:%f", currentRegion->site->x,
@@ -1,9 +1,33 @@
 #include "mapgen/SimulationWindow.hpp"
+#include "mapgen/BatchSimulator.hpp"
+#include "mapgen/PathCache.hpp"
 #include <imgui.h>
 
+const char *BATCH_VAR_NAMES[] = {"POPULATION_GROWS",
+                                 "POPULATION_GROWS_WEALTH_MODIFIER",
+                                 "PACKAGES_PER_NICE",
+                                 "PACKAGES_PER_MINERALS",
+                                 "CANT_BUY_AGRO",
+                                 "CANT_BUY_MINERALS",
+                                 "PORT_FEE"};
+float EconomyVars::*BATCH_VAR_FIELDS[] = {
+    &EconomyVars::POPULATION_GROWS,
+    &EconomyVars::POPULATION_GROWS_WEALTH_MODIFIER,
+    &EconomyVars::PACKAGES_PER_NICE,
+    &EconomyVars::PACKAGES_PER_MINERALS,
+    &EconomyVars::CANT_BUY_AGRO,
+    &EconomyVars::CANT_BUY_MINERALS,
+    &EconomyVars::PORT_FEE};
+
 SimulationWindow::SimulationWindow(sf::RenderWindow *w, MapGenerator *m)
     : window(w), mapgen(m) {}
 
+std::vector<EconomyVars> SimulationWindow::getBatchRuns() {
+  return BatchSimulator::sweep(*mapgen->simulator->vars,
+                               BATCH_VAR_FIELDS[batchVar], batchFrom, batchTo,
+                               batchRuns);
+}
+
 void SimulationWindow::draw() {
 
   ImGui::Text("Total cities count: %zu", mapgen->map->cities.size());
@@ -23,6 +47,25 @@ void SimulationWindow::draw() {
               std::count_if(mapgen->map->cities.begin(),
                             mapgen->map->cities.end(),
                             [](City *c) { return c->type == FORT; }));
+  if (mapgen->simulator->pathCache != nullptr) {
+    micropather::CacheData cd;
+    mapgen->simulator->pathCache->getCacheData(&cd);
+    ImGui::Text("Path cache: %d hits, %d misses (%.0f%%)", cd.hit, cd.miss,
+                cd.hitFraction * 100.f);
+  }
+  ImGui::Text("\n");
+
+  ImGui::Checkbox("Sparse road network", &mapgen->simulator->sparseRoads);
+  if (mapgen->simulator->sparseRoads) {
+    ImGui::SliderFloat("Detour ratio", &mapgen->simulator->detourRatio, 1.1f,
+                       5.f);
+  }
+  ImGui::SliderInt("Landmarks", &mapgen->map->landmarkCount, 0, 32);
+  ImGui::Checkbox("Sea lanes", &mapgen->map->useSeaLanes);
+  ImGui::Checkbox("Contraction hierarchy", &mapgen->simulator->useHierarchy);
+  if (!mapgen->simulator->useHierarchy) {
+    ImGui::Checkbox("Cluster pathfinding", &mapgen->simulator->useClusters);
+  }
   ImGui::Text("\n");
 
   if (ImGui::TreeNode("Economy variables")) {
@@ -170,4 +213,53 @@ void SimulationWindow::draw() {
     }
     ImGui::Text("\n");
   }
+
+  if (mapgen->simulator->report != nullptr && ImGui::TreeNode("Snapshots")) {
+    ImGui::InputInt("Continue years", &continueYears);
+    continueYears = std::max(1, continueYears);
+    if (mapgen->ready && ImGui::Button("Save snapshot")) {
+      mapgen->simulator->saveSnapshot();
+    }
+    auto snapshots = &mapgen->simulator->snapshots;
+    for (int i = 0; i < (int)snapshots->size(); i++) {
+      ImGui::PushID(i);
+      ImGui::Text("Year %d (%zu bytes)", snapshots->at(i).year * 10,
+                  snapshots->at(i).data.size());
+      ImGui::SameLine(200);
+      if (mapgen->ready && ImGui::Button("Restore")) {
+        restoreIndex = i;
+      }
+      ImGui::PopID();
+    }
+    ImGui::TreePop();
+  }
+
+  if (mapgen->simulator->report != nullptr &&
+      ImGui::TreeNode("Batch simulation")) {
+    ImGui::InputInt("Runs", &batchRuns);
+    batchRuns = std::max(1, batchRuns);
+    ImGui::Combo("Sweep", &batchVar, BATCH_VAR_NAMES, 7);
+    ImGui::DragFloat("From", &batchFrom, 0.01, 0.f, 1000.f);
+    ImGui::DragFloat("To", &batchTo, 0.01, 0.f, 1000.f);
+
+    auto batch = mapgen->simulator->batch;
+    if (batch != nullptr && batch->reports.size() > 0) {
+      char t[1000];
+      auto pop = &batch->population;
+      sprintf(t, "Mean: %f\nDeviation: %f\nMax: %f\nMin: %f", pop->mean,
+              pop->deviation, pop->max, pop->min);
+      auto h = pop->histogram(20);
+      ImGui::PlotHistogram(t, h.data(), h.size(), 0, "Final population",
+                           0.f, FLT_MAX, ImVec2(0, 100));
+
+      char tw[1000];
+      auto w = &batch->wealth;
+      sprintf(tw, "Mean: %f\nDeviation: %f\nMax: %f\nMin: %f", w->mean,
+              w->deviation, w->max, w->min);
+      auto hw = w->histogram(20);
+      ImGui::PlotHistogram(tw, hw.data(), hw.size(), 0, "Final wealth", 0.f,
+                           FLT_MAX, ImVec2(0, 100));
+    }
+    ImGui::TreePop();
+  }
 }
@@ -9,16 +9,6 @@ namespace mg {
 		return std::sqrt(distancex * distancex + distancey * distancey);
   }
 
-  template <typename T>
-  std::vector<T *> filterObjects(std::vector<T *> regions,
-                                      filterFunc<T> filter, sortFunc<T> sort) {
-    std::vector<T *> places;
-
-    std::copy_if(regions.begin(), regions.end(), std::back_inserter(places),
-                 filter);
-    std::sort(places.begin(), places.end(), sort);
-    return places;
-  }
   void before(std::string method) {
     std::cout << rang::fg::green << rang::style::bold << "[ -> ]\t" << rang::style::reset << method << std::endl << std::flush;
 